@@ -7,7 +7,9 @@
 #define SIZE 16
 
 #include "vec3.h"
+#include <algorithm>
 #include <array>
+#include <cmath>
 
 using namespace std;
 namespace bla {
@@ -192,6 +194,36 @@ namespace bla {
             return Matrix4(matrix);
         }
 
+        /**
+         * Creates an affine <code>Matrix4</code> from the images of the axes and of the origin.
+         * <p>
+         * The resulting matrix looks like:
+         * </p>
+         *
+         * <pre>
+         * |x.x y.x z.x t.x|
+         * |x.y y.y z.y t.y|
+         * |x.z y.z z.z t.z|
+         * | 0   0   0   1 |
+         * </pre>
+         *
+         * @param x
+         *            where the X axis is mapped to
+         * @param y
+         *            where the Y axis is mapped to
+         * @param z
+         *            where the Z axis is mapped to
+         * @param t
+         *            where the origin is mapped to
+         * @return a <code>Matrix4</code> that applies the transformation
+         */
+        static Matrix4 getAffineInstance(const Vector3 &x, const Vector3 &y, const Vector3 &z, const Vector3 &t) {
+            return Matrix4({x.x, x.y, x.z, 0.0,
+                            y.x, y.y, y.z, 0.0,
+                            z.x, z.y, z.z, 0.0,
+                            t.x, t.y, t.z, 1.0});
+        }
+
         //==================================
         //=======MATH/UTILITY METHODS=======
         //==================================
@@ -244,7 +276,7 @@ namespace bla {
          *            the <code>Matrix4</code> to multiply by.
          * @return a new <code>Matrix4</code> that is the result of T * M
          */
-        Matrix4 getMult(Matrix4 M) {
+        Matrix4 getMult(Matrix4 M) const {
             array<double, SIZE> newmat;
             array<double, SIZE> m1 = mat;
             array<double, SIZE> m2 = M.mat;
@@ -260,7 +292,7 @@ namespace bla {
             return Matrix4(newmat);
         }
 
-        inline Matrix4 operator+(Matrix4 &M) {
+        inline Matrix4 operator+(const Matrix4 &M) const {
             array<double, SIZE> matrix;
 
             for (int i = 0; i < SIZE; i++) {
@@ -270,7 +302,7 @@ namespace bla {
             return Matrix4(matrix);
         }
 
-        inline Matrix4 operator-(Matrix4 &M) {
+        inline Matrix4 operator-(const Matrix4 &M) const {
             array<double, SIZE> matrix;
 
             for (int i = 0; i < SIZE; i++) {
@@ -308,7 +340,7 @@ namespace bla {
          *            the <code>Vector3</code> to transform
          * @return a <code>Vector3</code> with the applied transformations
          */
-        Vector3 getTransformedVec(Vector3 v) {
+        Vector3 getTransformedVec(Vector3 v) const {
             double vec[] = {0.0, 0.0, 0.0};
 
             for (int i = 0; i < 3; i++) {
@@ -318,15 +350,71 @@ namespace bla {
             return Vector3(vec[0], vec[1], vec[2]);
         }
 
+        /**
+         * Inverts this <code>Matrix4</code>, assuming it is affine (its bottom row is
+         * <code>0 0 0 1</code>), as every combination of translations, rotations and
+         * scales is.
+         *
+         * @return the inverse, or the identity matrix if this matrix is singular
+         */
+        Matrix4 getInverse() const {
+            // Cofactors of the upper left 3x3 block, stored column major like mat.
+            array<double, SIZE> inv = idMtx;
+            inv[0] = mat[5] * mat[10] - mat[9] * mat[6];
+            inv[1] = mat[9] * mat[2] - mat[1] * mat[10];
+            inv[2] = mat[1] * mat[6] - mat[5] * mat[2];
+            inv[4] = mat[8] * mat[6] - mat[4] * mat[10];
+            inv[5] = mat[0] * mat[10] - mat[8] * mat[2];
+            inv[6] = mat[4] * mat[2] - mat[0] * mat[6];
+            inv[8] = mat[4] * mat[9] - mat[8] * mat[5];
+            inv[9] = mat[8] * mat[1] - mat[0] * mat[9];
+            inv[10] = mat[0] * mat[5] - mat[4] * mat[1];
+
+            double det = mat[0] * inv[0] + mat[4] * inv[1] + mat[8] * inv[2];
+            if (det == 0.0)
+                return Matrix4();
+
+            for (int i = 0; i < 11; i++) {
+                inv[i] /= det;
+            }
+            inv[3] = inv[7] = 0.0;
+
+            // The translation moves back by the inverted offset.
+            for (int i = 0; i < 3; i++) {
+                inv[i + 12] = -(inv[i] * mat[12] + inv[i + 4] * mat[13] + inv[i + 8] * mat[14]);
+            }
+
+            return Matrix4(inv);
+        }
+
+        /**
+         * @return the largest factor this matrix scales lengths by along any of its axes,
+         *         i.e. the largest norm of the first three columns; spheres scale their
+         *         radius by it so they still bound what the matrix makes of them
+         */
+        double getMaxScale() const {
+            double sx = mat[0] * mat[0] + mat[1] * mat[1] + mat[2] * mat[2];
+            double sy = mat[4] * mat[4] + mat[5] * mat[5] + mat[6] * mat[6];
+            double sz = mat[8] * mat[8] + mat[9] * mat[9] + mat[10] * mat[10];
+            return sqrt(max(sx, max(sy, sz)));
+        }
+
+        /**
+         * @return <b>true</b> if this is exactly the identity matrix
+         */
+        bool isIdentity() const {
+            return mat == idMtx;
+        }
+
         /**
          * Gets a copy of the internal array used to store this <code>Matrix4</code>'s data.
          * @return the matrix as an array
          */
-        array<double, 16> getMatrix(){
+        array<double, 16> getMatrix() const {
             return mat;
         }
 
-        string toString() {
+        string toString() const {
             string s = "";
 
             for (int i = 0; i < 4; i++) {
@@ -0,0 +1,216 @@
+#ifndef RAYTRACER_C_QUATERNION_H
+#define RAYTRACER_C_QUATERNION_H
+
+#include "vec3.h"
+#include <cmath>
+
+using namespace std;
+namespace bla {
+    /**
+     * Represents a rotation in 3D space as a unit quaternion:
+     * </b>
+     * <pre>w + xi + yj + zk</pre>
+     * </b>
+     * Rotations are combined with the quaternion product, which only takes 16 multiplications
+     * and, unlike a product of rotation matrices, can be brought back onto the unit sphere by
+     * a single division, so long chains of small rotations do not drift into shears.
+     *
+     * @see <a href="https://en.wikipedia.org/wiki/Quaternions_and_spatial_rotation">Quaternions and spatial rotation</a>
+     */
+    class Quaternion {
+    public:
+        /**The real part*/
+        double w;
+        /**The I part*/
+        double x;
+        /**The J part*/
+        double y;
+        /**The K part*/
+        double z;
+
+        /**
+         * Creates the identity rotation.
+         */
+        Quaternion() : w(1.0), x(0.0), y(0.0), z(0.0) {}
+
+        Quaternion(double w, double x, double y, double z) : w(w), x(x), y(y), z(z) {}
+
+        /**
+         * Creates a rotation around an axis.
+         *
+         * @param axis
+         *            the axis to rotate around; it does not need to be normalized
+         * @param theta
+         *            the angle of the rotation in radians
+         * @return a <code>Quaternion</code> that rotates by <b>theta</b> around <b>axis</b>,
+         *         counter-clockwise when looking down the axis
+         */
+        static Quaternion getRotationInstance(Vector3 axis, double theta) {
+            double l = axis.len();
+            if (l == 0.0)
+                return Quaternion();
+
+            double s = sin(theta * 0.5) / l;
+            return Quaternion(cos(theta * 0.5), axis.x * s, axis.y * s, axis.z * s);
+        }
+
+        /**
+         * Creates the rotation that turns the world axes into <b>x</b>, <b>y</b> and <b>z</b>.
+         *
+         * @param x
+         *            where the rotation takes <code>VEC_I</code>
+         * @param y
+         *            where the rotation takes <code>VEC_J</code>
+         * @param z
+         *            where the rotation takes <code>VEC_K</code>; the three must be orthonormal
+         *            and right handed
+         * @return the rotation, normalized
+         * @see <a href="https://en.wikipedia.org/wiki/Rotation_matrix#Quaternion">Rotation matrix to quaternion</a>
+         */
+        static Quaternion getBasisInstance(const Vector3 &x, const Vector3 &y, const Vector3 &z) {
+            // Divide by the largest of the four candidates for a stable result (Shepperd's method).
+            Quaternion q;
+            double trace = x.x + y.y + z.z;
+            if (trace > 0.0) {
+                double s = sqrt(trace + 1.0) * 2.0;
+                q = Quaternion(0.25 * s, (y.z - z.y) / s, (z.x - x.z) / s, (x.y - y.x) / s);
+            } else if (x.x > y.y && x.x > z.z) {
+                double s = sqrt(1.0 + x.x - y.y - z.z) * 2.0;
+                q = Quaternion((y.z - z.y) / s, 0.25 * s, (y.x + x.y) / s, (z.x + x.z) / s);
+            } else if (y.y > z.z) {
+                double s = sqrt(1.0 + y.y - x.x - z.z) * 2.0;
+                q = Quaternion((z.x - x.z) / s, (y.x + x.y) / s, 0.25 * s, (z.y + y.z) / s);
+            } else {
+                double s = sqrt(1.0 + z.z - x.x - y.y) * 2.0;
+                q = Quaternion((x.y - y.x) / s, (z.x + x.z) / s, (z.y + y.z) / s, 0.25 * s);
+            }
+            q.norm();
+            return q;
+        }
+
+        /**
+         * @return the same rotation as <code>Matrix4::getRotXInstance(theta)</code>
+         */
+        static Quaternion getRotXInstance(double theta) {
+            return Quaternion(cos(theta * 0.5), sin(theta * 0.5), 0.0, 0.0);
+        }
+
+        /**
+         * @return the same rotation as <code>Matrix4::getRotYInstance(theta)</code>
+         */
+        static Quaternion getRotYInstance(double theta) {
+            return Quaternion(cos(theta * 0.5), 0.0, sin(theta * 0.5), 0.0);
+        }
+
+        /**
+         * @return the same rotation as <code>Matrix4::getRotZInstance(theta)</code>
+         */
+        static Quaternion getRotZInstance(double theta) {
+            return Quaternion(cos(theta * 0.5), 0.0, 0.0, sin(theta * 0.5));
+        }
+
+        /**
+         * The Hamilton product. As with matrices, <code>(q * p).rotate(v)</code> rotates
+         * <b>v</b> by <b>p</b> first and by <b>q</b> second.
+         *
+         * @param q the other quaternion
+         * @return the product of this quaternion and <b>q</b>
+         */
+        Quaternion operator*(const Quaternion &q) const {
+            return Quaternion(w * q.w - x * q.x - y * q.y - z * q.z,
+                              w * q.x + x * q.w + y * q.z - z * q.y,
+                              w * q.y - x * q.z + y * q.w + z * q.x,
+                              w * q.z + x * q.y - y * q.x + z * q.w);
+        }
+
+        bool operator==(const Quaternion &q) const {
+            return w == q.w && x == q.x && y == q.y && z == q.z;
+        }
+
+        /**
+         * @return the 4D dot product of this quaternion and <b>q</b>
+         */
+        double dot(const Quaternion &q) const {
+            return w * q.w + x * q.x + y * q.y + z * q.z;
+        }
+
+        /**
+         * @return the length of the quaternion, 1 for a rotation
+         */
+        double len() const {
+            return sqrt(dot(*this));
+        }
+
+        /**
+         * Scales the quaternion back to unit length, undoing the rounding error of a
+         * product.
+         */
+        void norm() {
+            double l = len();
+            if (l == 0.0) {
+                *this = Quaternion();
+                return;
+            }
+            w /= l;
+            x /= l;
+            y /= l;
+            z /= l;
+        }
+
+        /**
+         * @return the inverse rotation
+         */
+        Quaternion conjugate() const {
+            return Quaternion(w, -x, -y, -z);
+        }
+
+        /**
+         * Rotates a <code>Vector3</code>, without building a matrix.
+         *
+         * @param v the vector to rotate
+         * @return <b>v</b> rotated by this quaternion
+         */
+        Vector3 rotate(const Vector3 &v) const {
+            // v + 2w(q x v) + 2q x (q x v), with q the vector part
+            Vector3 q(x, y, z);
+            Vector3 t = q.cross(v) * 2.0;
+            return v + t * w + q.cross(t);
+        }
+
+        /**
+         * Spherical linear interpolation along the shorter arc between two rotations. The
+         * angular velocity is constant, so motion samples spaced evenly in time are spaced
+         * evenly in angle.
+         *
+         * @param a the rotation at <b>t</b> = 0
+         * @param b the rotation at <b>t</b> = 1
+         * @param t where to interpolate, usually in [0, 1]
+         * @return the interpolated rotation
+         */
+        static Quaternion slerp(const Quaternion &a, Quaternion b, double t) {
+            double c = a.dot(b);
+            // q and -q are the same rotation; pick the one that is closer.
+            if (c < 0.0) {
+                b = Quaternion(-b.w, -b.x, -b.y, -b.z);
+                c = -c;
+            }
+
+            double wa, wb;
+            if (c > 0.9995) {
+                // Nearly parallel: sin(angle) is too small to divide by, and lerp is exact enough.
+                wa = 1.0 - t;
+                wb = t;
+            } else {
+                double angle = acos(c);
+                double s = sin(angle);
+                wa = sin((1.0 - t) * angle) / s;
+                wb = sin(t * angle) / s;
+            }
+
+            Quaternion q(a.w * wa + b.w * wb, a.x * wa + b.x * wb, a.y * wa + b.y * wb, a.z * wa + b.z * wb);
+            q.norm();
+            return q;
+        }
+    };
+}
+#endif //RAYTRACER_C_QUATERNION_H
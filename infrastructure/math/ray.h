@@ -53,7 +53,7 @@ namespace bla {
         Ray3(Vector3 origin, Vector3 direction) {
             o = origin;
             d = direction;
-            d.nor();
+            d.norm();
         }
 
         /**
@@ -61,7 +61,7 @@ namespace bla {
          * @param t the scalar to plug into the <a href="http://tutorial.math.lamar.edu/Classes/CalcIII/EqnsOfLines.aspx">ray equation</a>.
          * @return the point on the <code>Ray3</code> as a <code>Vector3</code>
          */
-        Vector3 getPoint(double t){
+        Vector3 getPoint(double t) const {
             return o + d * t;
         }
     };
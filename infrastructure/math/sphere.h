@@ -8,6 +8,7 @@
 #include "vec3.h"
 #include "ray.h"
 #include "transformable.h"
+#include <array>
 
 using namespace std;
 namespace bla {
@@ -41,8 +42,8 @@ namespace bla {
          * intersections, <code>{-1.0, -1.0}</code> is returned. If there is <b>1</b> intersection,
          * <code>{t1, -1.0}</code> is returned. If there are <b>2</b> intersections, <code>{t1, t2}</code> is returned.
          */
-        double *intersects(Ray3 ray) {
-            double ret[] = {-1.0, -1.0};
+        array<double, 2> intersects(const Ray3 &ray) const {
+            array<double, 2> ret = {-1.0, -1.0};
             // To understand what's going on here, check the wiki.
             Vector3 p = ray.o - c;
             double b = ray.d * p;
@@ -82,12 +83,28 @@ namespace bla {
             // Rotating a sphere does nothing.
         }
 
+        using Transformable::transform;
+
+        /**
+         * Moves the center by <b>M</b> and scales the radius by its largest axis scale. A
+         * non-uniform scale would make an ellipsoid; the radius takes the largest factor, so
+         * the sphere still bounds it.
+         *
+         * @param M the transform to apply
+         */
         void transform(Matrix4 M) {
-            array<double, 16> m = M.getMatrix();
+            c = M.getTransformedVec(c);
+            r *= M.getMaxScale();
+        }
 
-            c.x += m[12];
-            c.y += m[13];
-            c.z += m[14];
+        /**
+         * Same as baking <b>T</b> and handing it to <code>transform(Matrix4)</code>.
+         *
+         * @param T the transform to apply
+         */
+        void transform(const TRS &T) {
+            c = T.transformVec(c);
+            r *= T.maxScale();
         }
     };
 }
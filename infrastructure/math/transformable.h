@@ -7,6 +7,7 @@
 
 #include "vec3.h"
 #include "mat4.h"
+#include "trs.h"
 
 using namespace std;
 namespace bla{
@@ -20,12 +21,27 @@ namespace bla{
      */
     class Transformable{
     public:
+        virtual ~Transformable() {}
+
         virtual void translate(double x, double y, double z) = 0;
         virtual void translate(Vector3 v) = 0;
         virtual void rotX(double theta, bool aroundOrigin) = 0;
         virtual void rotY(double theta, bool aroundOrigin) = 0;
         virtual void rotZ(double theta, bool aroundOrigin) = 0;
         virtual void transform(Matrix4 M) =0;
+
+        /**
+         * Applies a decomposed transform. By default it is baked into a matrix and handed to
+         * <code>transform(Matrix4)</code>; implementations that store a <code>TRS</code>
+         * themselves can override this to compose it without the round trip. Implementations
+         * that override <code>transform(Matrix4)</code> need
+         * <code>using Transformable::transform;</code> to keep this overload visible.
+         *
+         * @param T the transform to apply
+         */
+        virtual void transform(const TRS &T) {
+            transform(T.getMatrix());
+        }
     };
 }
 #endif //RAYTRACER_C_TRANSFORMABLE_H
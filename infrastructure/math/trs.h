@@ -0,0 +1,196 @@
+#ifndef RAYTRACER_C_TRS_H
+#define RAYTRACER_C_TRS_H
+
+#include "mat4.h"
+#include "quaternion.h"
+#include "vec3.h"
+
+using namespace std;
+namespace bla {
+    /**
+     * A transform kept apart as a translation, a rotation and a scale, applied to a point
+     * <b>p</b> as
+     * </b>
+     * <pre>translation + rotation.rotate(scale * p)</pre>
+     * </b>
+     * where the scale is per axis. Unlike a <code>Matrix4</code> that is multiplied by one
+     * rotation after another, the rotation stays an exact rotation however long the chain
+     * of changes gets, and two poses can be interpolated directly for motion samples. The
+     * tracer still wants a matrix; <code>getMatrix()</code> bakes one when it is needed.
+     * <p>
+     * Rotations are around the world axes, as documented on <code>Matrix4::rotX</code>:
+     * with <b>aroundOrigin</b> the translation turns with them; without, the object turns
+     * in place.
+     * </p>
+     */
+    class TRS {
+    public:
+        Vector3 translation;
+        Quaternion rotation;
+        Vector3 scale;
+
+        /**
+         * Creates the identity transform.
+         */
+        TRS() : translation(VEC_ZERO), rotation(), scale(1.0, 1.0, 1.0) {}
+
+        TRS(const Vector3 &translation, const Quaternion &rotation, const Vector3 &scale = Vector3(1.0, 1.0, 1.0))
+                : translation(translation), rotation(rotation), scale(scale) {}
+
+        /**
+         * Decomposes an affine matrix, e.g. one handed to <code>Transformable::transform</code>.
+         * A shear has no place in a <code>TRS</code> and is dropped; a mirroring matrix turns
+         * into a negative x scale.
+         *
+         * @param M the matrix to decompose
+         * @return the transform <b>M</b> applies
+         */
+        static TRS fromMatrix(const Matrix4 &M) {
+            array<double, 16> m = M.getMatrix();
+            Vector3 axes[3] = {Vector3(m[0], m[1], m[2]), Vector3(m[4], m[5], m[6]), Vector3(m[8], m[9], m[10])};
+            const Vector3 world[3] = {VEC_I, VEC_J, VEC_K};
+            double s[3];
+            for (int i = 0; i < 3; i++) {
+                s[i] = axes[i].len();
+                axes[i] = s[i] > 0.0 ? axes[i] * (1.0 / s[i]) : world[i];
+            }
+            if (axes[0].cross(axes[1]) * axes[2] < 0.0) {
+                s[0] = -s[0];
+                axes[0] = axes[0] * -1.0;
+            }
+            // Gram-Schmidt takes out the shear, so the axes form a rotation.
+            axes[1] = axes[1] - axes[0] * (axes[0] * axes[1]);
+            axes[1].norm();
+            axes[2] = axes[0].cross(axes[1]);
+            return TRS(Vector3(m[12], m[13], m[14]), Quaternion::getBasisInstance(axes[0], axes[1], axes[2]),
+                       Vector3(s[0], s[1], s[2]));
+        }
+
+        /**
+         * @return the largest factor this transform scales lengths by along any axis
+         */
+        double maxScale() const {
+            return fmax(fabs(scale.x), fmax(fabs(scale.y), fabs(scale.z)));
+        }
+
+        /**
+         * Combines two transforms into one that applies <b>T</b> first and this one second,
+         * like <code>getMatrix().getMult(T.getMatrix())</code>. The result is exact if this
+         * transform scales uniformly. Otherwise a rotation in <b>T</b> followed by a
+         * non-uniform scale shears, which a <code>TRS</code> cannot hold: the product is
+         * decomposed with <code>fromMatrix</code>, which keeps the translation and the image
+         * of the x axis but drops the shear, so points off that axis can land elsewhere than
+         * under the matrix product. Compose matrices where that matters.
+         *
+         * @param T the transform applied first
+         * @return the combined transform
+         */
+        TRS operator*(const TRS &T) const {
+            if (scale.x == scale.y && scale.y == scale.z) {
+                Vector3 s(scale.x * T.scale.x, scale.x * T.scale.y, scale.x * T.scale.z);
+                Quaternion r = rotation * T.rotation;
+                r.norm();
+                return TRS(transformVec(T.translation), r, s);
+            }
+            return fromMatrix(getMatrix().getMult(T.getMatrix()));
+        }
+
+        /**
+         * @param v the point to transform
+         * @return <b>v</b> transformed, without building a matrix
+         */
+        Vector3 transformVec(const Vector3 &v) const {
+            return translation + rotation.rotate(Vector3(v.x * scale.x, v.y * scale.y, v.z * scale.z));
+        }
+
+        /**
+         * Bakes this transform into a matrix for the tracer.
+         *
+         * @return a <code>Matrix4</code> that applies the same transformation
+         */
+        Matrix4 getMatrix() const {
+            return Matrix4::getAffineInstance(rotation.rotate(VEC_I) * scale.x, rotation.rotate(VEC_J) * scale.y,
+                                              rotation.rotate(VEC_K) * scale.z, translation);
+        }
+
+        /**
+         * @return the inverse transform; exact if the scale is uniform, and <code>TRS</code>
+         *         cannot represent it otherwise, see <code>operator*</code>
+         */
+        TRS getInverse() const {
+            Quaternion r = rotation.conjugate();
+            Vector3 s(1.0 / scale.x, 1.0 / scale.y, 1.0 / scale.z);
+            Vector3 t = r.rotate(translation * -1.0);
+            return TRS(Vector3(t.x * s.x, t.y * s.y, t.z * s.z), r, s);
+        }
+
+        /**
+         * Interpolates between two poses: translation and scale linearly, rotation along the
+         * shorter arc at constant angular velocity.
+         *
+         * @param a the pose at <b>t</b> = 0
+         * @param b the pose at <b>t</b> = 1
+         * @param t where to interpolate, usually in [0, 1]
+         * @return the pose at <b>t</b>
+         */
+        static TRS interpolate(const TRS &a, const TRS &b, double t) {
+            return TRS(a.translation + (b.translation - a.translation) * t,
+                       Quaternion::slerp(a.rotation, b.rotation, t),
+                       a.scale + (b.scale - a.scale) * t);
+        }
+
+        //====================================
+        //=======TRANSFORMATION METHODS=======
+        //====================================
+
+        TRS *translate(double x, double y, double z) {
+            translation += Vector3(x, y, z);
+            return this;
+        }
+
+        TRS *translate(Vector3 v) {
+            translation += v;
+            return this;
+        }
+
+        /**
+         * Applies a rotation on top of the current one.
+         *
+         * @param q
+         *            the rotation to apply
+         * @param aroundOrigin
+         *            <b>true</b> if the rotation should occur around the global origin,
+         *            <b>false</b> if it should occur around the transform's own position
+         * @return a pointer to this transform for chaining purposes
+         */
+        TRS *rotate(const Quaternion &q, bool aroundOrigin) {
+            rotation = q * rotation;
+            rotation.norm();
+            if (aroundOrigin)
+                translation = q.rotate(translation);
+            return this;
+        }
+
+        /**
+         * @see TRS::rotate
+         */
+        TRS *rotX(double theta, bool aroundOrigin) {
+            return rotate(Quaternion::getRotXInstance(theta), aroundOrigin);
+        }
+
+        /**
+         * @see TRS::rotate
+         */
+        TRS *rotY(double theta, bool aroundOrigin) {
+            return rotate(Quaternion::getRotYInstance(theta), aroundOrigin);
+        }
+
+        /**
+         * @see TRS::rotate
+         */
+        TRS *rotZ(double theta, bool aroundOrigin) {
+            return rotate(Quaternion::getRotZInstance(theta), aroundOrigin);
+        }
+    };
+}
+#endif //RAYTRACER_C_TRS_H
@@ -20,6 +20,14 @@ namespace bla {
 
     const Vector3 Vector3::kVec = Vector3(0.0, 0.0, 1.0);
 
+    const Vector3 VEC_ZERO = Vector3::zeroVec;
+
+    const Vector3 VEC_I = Vector3::iVec;
+
+    const Vector3 VEC_J = Vector3::jVec;
+
+    const Vector3 VEC_K = Vector3::kVec;
+
 
     Vector3::Vector3(double _x, double _y, double _z) 
         : x(_x)
@@ -31,11 +39,11 @@ namespace bla {
         z = _z;
     }
 
-    Vector3 Vector3::operator+(Vector3 &v) {
+    Vector3 Vector3::operator+(const Vector3 &v) const {
         return Vector3(x + v.x, y + v.y, z + v.z);
     }
 
-    Vector3& Vector3::operator+=(Vector3 &v) {
+    Vector3& Vector3::operator+=(const Vector3 &v) {
         this->x += v.x;
         this->y += v.y;
         this->z += v.z;
@@ -43,11 +51,11 @@ namespace bla {
         return *this;
     }
 
-    Vector3 Vector3::operator-(Vector3 &v) {
+    Vector3 Vector3::operator-(const Vector3 &v) const {
         return Vector3(x - v.x, y - v.y, z - v.z);
     }
 
-    Vector3& Vector3::operator-=(Vector3 &v) {
+    Vector3& Vector3::operator-=(const Vector3 &v) {
         this->x -= v.x;
         this->y -= v.y;
         this->z -= v.z;
@@ -60,7 +68,7 @@ namespace bla {
      * @param scalar the scalar
      * @return the vector scaled by <b>s</b>
      */
-    Vector3 Vector3::operator*(double scalar) {
+    Vector3 Vector3::operator*(double scalar) const {
         return Vector3(scalar * x, scalar * y, scalar * z);
     }
 
@@ -77,7 +85,7 @@ namespace bla {
     * @param scalar the scalar
     * @return the vector scaled by <b>s</b>
     */
-    Vector3 Vector3::operator*(int scalar) {
+    Vector3 Vector3::operator*(int scalar) const {
         double s = (double) scalar;//the scalar as a double
         return Vector3(s * x, s * y, s * z);
     }
@@ -96,7 +104,7 @@ namespace bla {
     * @param scalar the scalar
     * @return the vector scaled by <b>s</b>
     */
-    Vector3 Vector3::operator*(float scalar) {
+    Vector3 Vector3::operator*(float scalar) const {
         double s = (double) scalar;//the scalar as a double
         return Vector3(s * x, s * y, s * z);
     }
@@ -106,6 +114,8 @@ namespace bla {
         x *= s;
         y *= s;
         z *= s;
+
+        return *this;
     }
 
     /**
@@ -113,11 +123,11 @@ namespace bla {
      * @param u the other vector to use in the calculation
      * @return the dot product between this vector and u
      */
-    double Vector3::operator*(const Vector3 v) {
+    double Vector3::operator*(const Vector3 v) const {
         return v.x * x + v.y * y + v.z * z;
     }
 
-    bool Vector3::operator==(const Vector3 v){
+    bool Vector3::operator==(const Vector3 v) const {
         return x==v.x && y==v.y && z==v.z;
     }
 
@@ -125,7 +135,7 @@ namespace bla {
      * Takes the dot product of this vector with itself (i.e: squaring the vector). Shorthand for v * v.
      * @return the result from the operation
      */
-    inline double Vector3::sqr() {
+    double Vector3::sqr() const {
         return x * x + y * y + z * z;
     }
 
@@ -134,7 +144,7 @@ namespace bla {
      * @param v the other vector used in the calculation
      * @return the cross product of this vector and <b>v</b>
      */
-    inline Vector3 Vector3::cross(const Vector3 v) {
+    Vector3 Vector3::cross(const Vector3 v) const {
         return Vector3(
                 y * v.z - z * v.y,
                 z * v.x - x * v.z,
@@ -145,7 +155,7 @@ namespace bla {
     /*
      * Computes the distance between two vectors.
      */
-    inline float Vector3::dist(const Vector3 v) {
+    float Vector3::dist(const Vector3 v) const {
         float dx = x - v.x;
         float dy = y - v.y;
         float dz = z - v.z;
@@ -156,14 +166,14 @@ namespace bla {
     /**
      * @return the length of the vector
      */
-    inline double Vector3::len() {
+    double Vector3::len() const {
         return sqrt(x * x + y * y + z * z);
     }
 
     /**
      * Normalizes the vector, turning it into a unit vector.
      */
-    inline void Vector3::norm() {
+    void Vector3::norm() {
         double l = len();
         x /= l;
         y /= l;
@@ -173,7 +183,7 @@ namespace bla {
     /**
      * @return the vector as a string
      */
-    inline string Vector3::toString() {
+    string Vector3::toString() const {
         return "<" + to_string(x) + ", " + to_string(y) + ", " + to_string(z) + ">";
     }
 
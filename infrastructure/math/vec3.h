@@ -43,20 +43,20 @@ namespace bla {
          */
         Vector3(double _x = 0.0, double _y = 0.0, double _z=0.0);
 
-        Vector3 operator+(Vector3 &v);
+        Vector3 operator+(const Vector3 &v) const;
 
-        Vector3& operator+=(Vector3 &v);
+        Vector3& operator+=(const Vector3 &v);
 
-        Vector3 operator-(Vector3 &v);
+        Vector3 operator-(const Vector3 &v) const;
 
-        Vector3& operator-=(Vector3 &v);
+        Vector3& operator-=(const Vector3 &v);
 
         /**
          * Scalar multiplication.
          * @param scalar the scalar
          * @return the vector scaled by <b>s</b>
          */
-        Vector3 operator*(double scalar);
+        Vector3 operator*(double scalar) const;
 
         Vector3& operator*=(double scalar);
 
@@ -65,7 +65,7 @@ namespace bla {
         * @param scalar the scalar
         * @return the vector scaled by <b>s</b>
         */
-        Vector3 operator*(int scalar);
+        Vector3 operator*(int scalar) const;
 
         Vector3& operator*=(int scalar);
 
@@ -74,7 +74,7 @@ namespace bla {
         * @param scalar the scalar
         * @return the vector scaled by <b>s</b>
         */
-        Vector3 operator*(float scalar);
+        Vector3 operator*(float scalar) const;
 
         Vector3 operator*=(float scalar);
 
@@ -83,42 +83,42 @@ namespace bla {
          * @param u the other vector to use in the calculation
          * @return the dot product between this vector and u
          */
-        double operator*(const Vector3 v);
+        double operator*(const Vector3 v) const;
 
-        bool operator==(const Vector3 v);
+        bool operator==(const Vector3 v) const;
 
         /**
          * Takes the dot product of this vector with itself (i.e: squaring the vector). Shorthand for v * v.
          * @return the result from the operation
          */
-        inline double sqr();
+        double sqr() const;
 
         /**
          * Takes the cross product of this vector and <b>v</b>.
          * @param v the other vector used in the calculation
          * @return the cross product of this vector and <b>v</b>
          */
-        inline Vector3 cross(const Vector3 v);
+        Vector3 cross(const Vector3 v) const;
 
         /*
          * Computes the distance between two vectors.
          */
-        inline float dist(const Vector3 v);
+        float dist(const Vector3 v) const;
 
         /**
          * @return the length of the vector
          */
-        inline double len();
+        double len() const;
 
         /**
          * Normalizes the vector, turning it into a unit vector.
          */
-        inline void norm();
+        void norm();
 
         /**
          * @return the vector as a string
          */
-        inline string toString();
+        string toString() const;
 
       // static singletons
 
@@ -136,5 +136,17 @@ namespace bla {
 
     };
 
+    /**Zero vector.*/
+    extern const Vector3 VEC_ZERO;
+
+    /**Unit vector I.*/
+    extern const Vector3 VEC_I;
+
+    /**Unit vector J.*/
+    extern const Vector3 VEC_J;
+
+    /**Unit vector K.*/
+    extern const Vector3 VEC_K;
+
 }
 #endif //RAYTRACER_C_VEC3_H
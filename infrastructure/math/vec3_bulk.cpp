@@ -0,0 +1,132 @@
+/**
+* Runtime selection of the bulk Vector3 kernels.
+*/
+
+#include "vec3_bulk.h"
+#include "vec3_bulk_kernels.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#define BLA_X86 1
+#endif
+
+using namespace std;
+
+namespace bla {
+    // Defined in vec3_bulk_<isa>.cpp. They return nullptr when the compiler could not target the ISA.
+    const Vector3Kernels *sse42Vector3Kernels();
+    const Vector3Kernels *avx2Vector3Kernels();
+    const Vector3Kernels *avx512Vector3Kernels();
+
+    namespace {
+        constexpr Vector3Kernels scalarKernels = makeVector3Kernels<ScalarLane>(Isa::Scalar, "scalar");
+
+#ifdef BLA_X86
+        /**
+         * Reads the XCR0 register, which tells which register states the OS saves on a context switch.
+         */
+        unsigned long long xgetbv0() {
+            unsigned int lo, hi;
+            __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+            return ((unsigned long long) hi << 32) | lo;
+        }
+#endif
+
+        /**
+         * Parses the value of the <code>BLA_VEC3_ISA</code> environment variable.
+         *
+         * @return <b>true</b> if <b>s</b> names an instruction set
+         */
+        bool parseIsa(const char *s, Isa *isa) {
+            if (strcmp(s, "scalar") == 0) *isa = Isa::Scalar;
+            else if (strcmp(s, "sse4.2") == 0 || strcmp(s, "sse42") == 0) *isa = Isa::SSE42;
+            else if (strcmp(s, "avx2") == 0) *isa = Isa::AVX2;
+            else if (strcmp(s, "avx512") == 0 || strcmp(s, "avx512f") == 0) *isa = Isa::AVX512;
+            else return false;
+            return true;
+        }
+
+        const Vector3Kernels &selectKernels() {
+            const char *env = getenv("BLA_VEC3_ISA");
+            Isa forced;
+
+            if (env != nullptr && *env != '\0') {
+                if (!parseIsa(env, &forced)) {
+                    cerr << "BLA_VEC3_ISA: unknown instruction set '" << env << "', ignoring" << endl;
+                } else if (const Vector3Kernels *k = vector3Kernels(forced)) {
+                    return *k;
+                } else {
+                    cerr << "BLA_VEC3_ISA: '" << env << "' is not supported on this machine, ignoring" << endl;
+                }
+            }
+
+            const Isa order[] = {Isa::AVX512, Isa::AVX2, Isa::SSE42};
+            for (Isa isa : order) {
+                if (const Vector3Kernels *k = vector3Kernels(isa))
+                    return *k;
+            }
+
+            return scalarKernels;
+        }
+    }
+
+    bool isaSupported(Isa isa) {
+        if (isa == Isa::Scalar)
+            return true;
+#ifdef BLA_X86
+        unsigned int eax, ebx, ecx, edx;
+        if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+            return false;
+
+        bool sse42 = (ecx & bit_SSE4_2) != 0;
+        if (isa == Isa::SSE42)
+            return sse42;
+
+        // Anything using YMM/ZMM registers also needs the OS to save them (OSXSAVE + XCR0).
+        bool osxsave = (ecx & bit_OSXSAVE) != 0;
+        bool avx = (ecx & bit_AVX) != 0;
+        if (!osxsave || !avx)
+            return false;
+        unsigned long long xcr0 = xgetbv0();
+        if ((xcr0 & 0x6) != 0x6)
+            return false;
+
+        if (__get_cpuid_max(0, nullptr) < 7)
+            return false;
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+
+        if (isa == Isa::AVX2)
+            return (ebx & bit_AVX2) != 0;
+
+        // Opmask, upper ZMM0-15 and ZMM16-31 state.
+        if (isa == Isa::AVX512)
+            return (ebx & bit_AVX512F) != 0 && (xcr0 & 0xe0) == 0xe0;
+#endif
+        return false;
+    }
+
+    const Vector3Kernels *vector3Kernels(Isa isa) {
+        if (!isaSupported(isa))
+            return nullptr;
+
+        switch (isa) {
+            case Isa::Scalar:
+                return &scalarKernels;
+            case Isa::SSE42:
+                return sse42Vector3Kernels();
+            case Isa::AVX2:
+                return avx2Vector3Kernels();
+            case Isa::AVX512:
+                return avx512Vector3Kernels();
+        }
+        return nullptr;
+    }
+
+    const Vector3Kernels &vector3Kernels() {
+        static const Vector3Kernels &kernels = selectKernels();
+        return kernels;
+    }
+}
@@ -0,0 +1,93 @@
+/**
+* Bulk (structure of arrays) versions of the <code>Vector3</code> operations.
+*
+* The kernels are compiled once per instruction set (scalar, SSE4.2, AVX2 and
+* AVX-512) and the best one supported by the host CPU is picked the first time
+* <code>vector3Kernels()</code> is called. Setting the <code>BLA_VEC3_ISA</code>
+* environment variable to <code>scalar</code>, <code>sse4.2</code>,
+* <code>avx2</code> or <code>avx512</code> forces a specific implementation,
+* which is useful for testing.
+*/
+#ifndef RAYTRACER_C_VEC3_BULK_H
+#define RAYTRACER_C_VEC3_BULK_H
+
+#include "vec3.h"
+#include "vec3_bulk_table.h"
+#include <vector>
+
+using namespace std;
+namespace bla {
+    /**
+     * Gets the kernel table for the host CPU. The table is selected once, on the first
+     * call, and the same table is returned afterwards.
+     *
+     * @return the fastest kernel table supported by the host, or the one requested by
+     * the <code>BLA_VEC3_ISA</code> environment variable
+     */
+    const Vector3Kernels &vector3Kernels();
+
+    /**
+     * Gets the kernel table for a specific instruction set.
+     *
+     * @param isa the instruction set
+     * @return the kernel table, or <code>nullptr</code> if this build or the host CPU
+     * does not support <b>isa</b>
+     */
+    const Vector3Kernels *vector3Kernels(Isa isa);
+
+    /**
+     * Checks whether the host CPU (and operating system) supports an instruction set.
+     *
+     * @param isa the instruction set to check
+     * @return <b>true</b> if code compiled for <b>isa</b> may run on this machine
+     */
+    bool isaSupported(Isa isa);
+
+    /**
+     * A growable list of <code>Vector3</code>s stored as a structure of arrays, so it
+     * can be handed directly to the bulk kernels.
+     */
+    class Vector3Array {
+    public:
+        vector<double> x;
+        vector<double> y;
+        vector<double> z;
+
+        Vector3Array(size_t n = 0) : x(n), y(n), z(n) {}
+
+        size_t size() const {
+            return x.size();
+        }
+
+        void resize(size_t n) {
+            x.resize(n);
+            y.resize(n);
+            z.resize(n);
+        }
+
+        void push_back(const Vector3 &v) {
+            x.push_back(v.x);
+            y.push_back(v.y);
+            z.push_back(v.z);
+        }
+
+        Vector3 get(size_t i) const {
+            return Vector3(x[i], y[i], z[i]);
+        }
+
+        void set(size_t i, const Vector3 &v) {
+            x[i] = v.x;
+            y[i] = v.y;
+            z[i] = v.z;
+        }
+
+        Vector3Span span() const {
+            return Vector3Span{x.data(), y.data(), z.data()};
+        }
+
+        Vector3MutSpan span() {
+            return Vector3MutSpan{x.data(), y.data(), z.data()};
+        }
+    };
+}
+#endif //RAYTRACER_C_VEC3_BULK_H
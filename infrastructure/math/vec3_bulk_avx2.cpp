@@ -0,0 +1,39 @@
+/**
+* AVX2 build of the bulk Vector3 kernels. This file is compiled with -mavx2.
+*/
+
+#include "vec3_bulk_kernels.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+
+namespace bla {
+    namespace {
+        struct Avx2Lane {
+            typedef __m256d reg;
+            static const size_t width = 4;
+
+            static reg load(const double *p) { return _mm256_loadu_pd(p); }
+            static void store(double *p, reg v) { _mm256_storeu_pd(p, v); }
+            static reg set1(double s) { return _mm256_set1_pd(s); }
+            static reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+            static reg sub(reg a, reg b) { return _mm256_sub_pd(a, b); }
+            static reg mul(reg a, reg b) { return _mm256_mul_pd(a, b); }
+            static reg div(reg a, reg b) { return _mm256_div_pd(a, b); }
+            static reg sqrt(reg a) { return _mm256_sqrt_pd(a); }
+        };
+
+        constexpr Vector3Kernels avx2Kernels = makeVector3Kernels<Avx2Lane>(Isa::AVX2, "avx2");
+    }
+
+    const Vector3Kernels *avx2Vector3Kernels() {
+        return &avx2Kernels;
+    }
+}
+#else
+namespace bla {
+    const Vector3Kernels *avx2Vector3Kernels() {
+        return nullptr;
+    }
+}
+#endif
@@ -0,0 +1,41 @@
+/**
+* AVX-512 build of the bulk Vector3 kernels. This file is compiled with -mavx512f.
+*/
+
+#include "vec3_bulk_kernels.h"
+
+#ifdef __AVX512F__
+#include <immintrin.h>
+
+namespace bla {
+    namespace {
+        struct Avx512Lane {
+            typedef __m512d reg;
+            static const size_t width = 8;
+
+            static reg load(const double *p) { return _mm512_loadu_pd(p); }
+            static void store(double *p, reg v) { _mm512_storeu_pd(p, v); }
+            static reg set1(double s) { return _mm512_set1_pd(s); }
+            static reg add(reg a, reg b) { return _mm512_add_pd(a, b); }
+            static reg sub(reg a, reg b) { return _mm512_sub_pd(a, b); }
+            static reg mul(reg a, reg b) { return _mm512_mul_pd(a, b); }
+            static reg div(reg a, reg b) { return _mm512_div_pd(a, b); }
+            // _mm512_sqrt_pd passes an undefined register through the masked-off lanes, which
+            // GCC warns about; with every lane enabled the pass-through value is never used.
+            static reg sqrt(reg a) { return _mm512_mask_sqrt_pd(a, (__mmask8) 0xff, a); }
+        };
+
+        constexpr Vector3Kernels avx512Kernels = makeVector3Kernels<Avx512Lane>(Isa::AVX512, "avx512");
+    }
+
+    const Vector3Kernels *avx512Vector3Kernels() {
+        return &avx512Kernels;
+    }
+}
+#else
+namespace bla {
+    const Vector3Kernels *avx512Vector3Kernels() {
+        return nullptr;
+    }
+}
+#endif
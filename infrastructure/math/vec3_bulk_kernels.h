@@ -0,0 +1,185 @@
+/**
+* Instruction set independent bodies of the bulk <code>Vector3</code> kernels.
+*
+* This header is only meant to be included by the <code>vec3_bulk_*.cpp</code> files.
+* Each of them defines a <code>Lane</code> type wrapping the registers of one
+* instruction set and instantiates <code>makeVector3Kernels</code> with it. Everything
+* in here lives in an anonymous namespace so that the copies compiled with different
+* target flags never get merged by the linker.
+*/
+#ifndef RAYTRACER_C_VEC3_BULK_KERNELS_H
+#define RAYTRACER_C_VEC3_BULK_KERNELS_H
+
+#include "vec3_bulk_table.h"
+#include <cmath>
+
+namespace bla {
+    namespace {
+        /**
+         * Lane type for the scalar tail of every kernel (and for the scalar build).
+         */
+        struct ScalarLane {
+            typedef double reg;
+            static const size_t width = 1;
+
+            static reg load(const double *p) { return *p; }
+            static void store(double *p, reg v) { *p = v; }
+            static reg set1(double s) { return s; }
+            static reg add(reg a, reg b) { return a + b; }
+            static reg sub(reg a, reg b) { return a - b; }
+            static reg mul(reg a, reg b) { return a * b; }
+            static reg div(reg a, reg b) { return a / b; }
+            static reg sqrt(reg a) { return std::sqrt(a); }
+        };
+
+        template<class L>
+        inline typename L::reg dot3(typename L::reg ax, typename L::reg ay, typename L::reg az,
+                                    typename L::reg bx, typename L::reg by, typename L::reg bz) {
+            return L::add(L::add(L::mul(ax, bx), L::mul(ay, by)), L::mul(az, bz));
+        }
+
+        //==================================
+        //=======PER-BLOCK OPERATIONS=======
+        //==================================
+
+        template<class L>
+        inline void dotAt(Vector3Span a, Vector3Span b, double *out, size_t i) {
+            L::store(out + i, dot3<L>(L::load(a.x + i), L::load(a.y + i), L::load(a.z + i),
+                                      L::load(b.x + i), L::load(b.y + i), L::load(b.z + i)));
+        }
+
+        template<class L>
+        inline void crossAt(Vector3Span a, Vector3Span b, Vector3MutSpan out, size_t i) {
+            typename L::reg ax = L::load(a.x + i), ay = L::load(a.y + i), az = L::load(a.z + i);
+            typename L::reg bx = L::load(b.x + i), by = L::load(b.y + i), bz = L::load(b.z + i);
+
+            L::store(out.x + i, L::sub(L::mul(ay, bz), L::mul(az, by)));
+            L::store(out.y + i, L::sub(L::mul(az, bx), L::mul(ax, bz)));
+            L::store(out.z + i, L::sub(L::mul(ax, by), L::mul(ay, bx)));
+        }
+
+        template<class L>
+        inline void lenAt(Vector3Span a, double *out, size_t i) {
+            typename L::reg x = L::load(a.x + i), y = L::load(a.y + i), z = L::load(a.z + i);
+            L::store(out + i, L::sqrt(dot3<L>(x, y, z, x, y, z)));
+        }
+
+        template<class L>
+        inline void normAt(Vector3MutSpan a, size_t i) {
+            typename L::reg x = L::load(a.x + i), y = L::load(a.y + i), z = L::load(a.z + i);
+            typename L::reg l = L::sqrt(dot3<L>(x, y, z, x, y, z));
+
+            L::store(a.x + i, L::div(x, l));
+            L::store(a.y + i, L::div(y, l));
+            L::store(a.z + i, L::div(z, l));
+        }
+
+        template<class L>
+        inline void distAt(Vector3Span a, Vector3Span b, double *out, size_t i) {
+            typename L::reg dx = L::sub(L::load(a.x + i), L::load(b.x + i));
+            typename L::reg dy = L::sub(L::load(a.y + i), L::load(b.y + i));
+            typename L::reg dz = L::sub(L::load(a.z + i), L::load(b.z + i));
+            L::store(out + i, L::sqrt(dot3<L>(dx, dy, dz, dx, dy, dz)));
+        }
+
+        template<class L>
+        inline void scaleAt(Vector3Span a, double s, Vector3MutSpan out, size_t i) {
+            typename L::reg sv = L::set1(s);
+
+            L::store(out.x + i, L::mul(L::load(a.x + i), sv));
+            L::store(out.y + i, L::mul(L::load(a.y + i), sv));
+            L::store(out.z + i, L::mul(L::load(a.z + i), sv));
+        }
+
+        template<class L>
+        inline void addAt(Vector3Span a, Vector3Span b, Vector3MutSpan out, size_t i) {
+            L::store(out.x + i, L::add(L::load(a.x + i), L::load(b.x + i)));
+            L::store(out.y + i, L::add(L::load(a.y + i), L::load(b.y + i)));
+            L::store(out.z + i, L::add(L::load(a.z + i), L::load(b.z + i)));
+        }
+
+        template<class L>
+        inline void scaleAddAt(Vector3Span a, Vector3Span b, double s, Vector3MutSpan out, size_t i) {
+            typename L::reg sv = L::set1(s);
+
+            L::store(out.x + i, L::add(L::load(a.x + i), L::mul(L::load(b.x + i), sv)));
+            L::store(out.y + i, L::add(L::load(a.y + i), L::mul(L::load(b.y + i), sv)));
+            L::store(out.z + i, L::add(L::load(a.z + i), L::mul(L::load(b.z + i), sv)));
+        }
+
+        //===========================
+        //=======KERNEL BODIES=======
+        //===========================
+
+        // Each kernel runs full-width blocks with L and finishes the remainder with ScalarLane.
+
+        template<class L>
+        void dotKernel(Vector3Span a, Vector3Span b, double *out, size_t n) {
+            size_t i = 0;
+            for (; i + L::width <= n; i += L::width) dotAt<L>(a, b, out, i);
+            for (; i < n; i++) dotAt<ScalarLane>(a, b, out, i);
+        }
+
+        template<class L>
+        void crossKernel(Vector3Span a, Vector3Span b, Vector3MutSpan out, size_t n) {
+            size_t i = 0;
+            for (; i + L::width <= n; i += L::width) crossAt<L>(a, b, out, i);
+            for (; i < n; i++) crossAt<ScalarLane>(a, b, out, i);
+        }
+
+        template<class L>
+        void lenKernel(Vector3Span a, double *out, size_t n) {
+            size_t i = 0;
+            for (; i + L::width <= n; i += L::width) lenAt<L>(a, out, i);
+            for (; i < n; i++) lenAt<ScalarLane>(a, out, i);
+        }
+
+        template<class L>
+        void normKernel(Vector3MutSpan a, size_t n) {
+            size_t i = 0;
+            for (; i + L::width <= n; i += L::width) normAt<L>(a, i);
+            for (; i < n; i++) normAt<ScalarLane>(a, i);
+        }
+
+        template<class L>
+        void distKernel(Vector3Span a, Vector3Span b, double *out, size_t n) {
+            size_t i = 0;
+            for (; i + L::width <= n; i += L::width) distAt<L>(a, b, out, i);
+            for (; i < n; i++) distAt<ScalarLane>(a, b, out, i);
+        }
+
+        template<class L>
+        void scaleKernel(Vector3Span a, double s, Vector3MutSpan out, size_t n) {
+            size_t i = 0;
+            for (; i + L::width <= n; i += L::width) scaleAt<L>(a, s, out, i);
+            for (; i < n; i++) scaleAt<ScalarLane>(a, s, out, i);
+        }
+
+        template<class L>
+        void addKernel(Vector3Span a, Vector3Span b, Vector3MutSpan out, size_t n) {
+            size_t i = 0;
+            for (; i + L::width <= n; i += L::width) addAt<L>(a, b, out, i);
+            for (; i < n; i++) addAt<ScalarLane>(a, b, out, i);
+        }
+
+        template<class L>
+        void scaleAddKernel(Vector3Span a, Vector3Span b, double s, Vector3MutSpan out, size_t n) {
+            size_t i = 0;
+            for (; i + L::width <= n; i += L::width) scaleAddAt<L>(a, b, s, out, i);
+            for (; i < n; i++) scaleAddAt<ScalarLane>(a, b, s, out, i);
+        }
+
+        /**
+         * Builds the kernel table for lane type <b>L</b>. This is <code>constexpr</code> so the tables
+         * are constant-initialized: the ISA specific files must not run any code at static init time,
+         * since that would happen before we know whether the CPU supports their instruction set.
+         */
+        template<class L>
+        constexpr Vector3Kernels makeVector3Kernels(Isa isa, const char *name) {
+            return Vector3Kernels{isa, name,
+                                  dotKernel<L>, crossKernel<L>, lenKernel<L>, normKernel<L>,
+                                  distKernel<L>, scaleKernel<L>, addKernel<L>, scaleAddKernel<L>};
+        }
+    }
+}
+#endif //RAYTRACER_C_VEC3_BULK_KERNELS_H
@@ -0,0 +1,39 @@
+/**
+* SSE4.2 build of the bulk Vector3 kernels. This file is compiled with -msse4.2.
+*/
+
+#include "vec3_bulk_kernels.h"
+
+#ifdef __SSE4_2__
+#include <nmmintrin.h>
+
+namespace bla {
+    namespace {
+        struct Sse42Lane {
+            typedef __m128d reg;
+            static const size_t width = 2;
+
+            static reg load(const double *p) { return _mm_loadu_pd(p); }
+            static void store(double *p, reg v) { _mm_storeu_pd(p, v); }
+            static reg set1(double s) { return _mm_set1_pd(s); }
+            static reg add(reg a, reg b) { return _mm_add_pd(a, b); }
+            static reg sub(reg a, reg b) { return _mm_sub_pd(a, b); }
+            static reg mul(reg a, reg b) { return _mm_mul_pd(a, b); }
+            static reg div(reg a, reg b) { return _mm_div_pd(a, b); }
+            static reg sqrt(reg a) { return _mm_sqrt_pd(a); }
+        };
+
+        constexpr Vector3Kernels sse42Kernels = makeVector3Kernels<Sse42Lane>(Isa::SSE42, "sse4.2");
+    }
+
+    const Vector3Kernels *sse42Vector3Kernels() {
+        return &sse42Kernels;
+    }
+}
+#else
+namespace bla {
+    const Vector3Kernels *sse42Vector3Kernels() {
+        return nullptr;
+    }
+}
+#endif
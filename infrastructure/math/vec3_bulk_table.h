@@ -0,0 +1,75 @@
+/**
+* The span and kernel table types of the bulk <code>Vector3</code> kernels.
+*
+* The <code>vec3_bulk_*.cpp</code> files compiled with instruction set flags include only
+* this header. An inline function they called would be emitted as a weak copy using their
+* instruction set, and the linker could pick that copy for callers running on CPUs without
+* it; the one inline function here, the span conversion, is never called by the kernels.
+*/
+#ifndef RAYTRACER_C_VEC3_BULK_TABLE_H
+#define RAYTRACER_C_VEC3_BULK_TABLE_H
+
+#include <cstddef>
+
+namespace bla {
+    /**
+     * A read-only view of <code>n</code> vectors stored as three separate arrays.
+     */
+    struct Vector3Span {
+        const double *x;
+        const double *y;
+        const double *z;
+    };
+
+    /**
+     * A writable view of <code>n</code> vectors stored as three separate arrays.
+     */
+    struct Vector3MutSpan {
+        double *x;
+        double *y;
+        double *z;
+
+        operator Vector3Span() const {
+            return Vector3Span{x, y, z};
+        }
+    };
+
+    /**
+     * The instruction sets the bulk kernels are built for, from slowest to fastest.
+     */
+    enum class Isa {
+        Scalar = 0,
+        SSE42 = 1,
+        AVX2 = 2,
+        AVX512 = 3
+    };
+
+    /**
+     * A table of bulk <code>Vector3</code> kernels for one instruction set. Every kernel
+     * processes <code>n</code> elements. Output arrays may alias input arrays.
+     */
+    struct Vector3Kernels {
+        /**The instruction set these kernels were compiled for*/
+        Isa isa;
+        /**A human readable name for the instruction set*/
+        const char *name;
+
+        /**out[i] = a[i] * b[i]*/
+        void (*dot)(Vector3Span a, Vector3Span b, double *out, size_t n);
+        /**out[i] = a[i] x b[i]*/
+        void (*cross)(Vector3Span a, Vector3Span b, Vector3MutSpan out, size_t n);
+        /**out[i] = |a[i]|*/
+        void (*len)(Vector3Span a, double *out, size_t n);
+        /**a[i] = a[i] / |a[i]|*/
+        void (*norm)(Vector3MutSpan a, size_t n);
+        /**out[i] = |a[i] - b[i]|*/
+        void (*dist)(Vector3Span a, Vector3Span b, double *out, size_t n);
+        /**out[i] = a[i] * s*/
+        void (*scale)(Vector3Span a, double s, Vector3MutSpan out, size_t n);
+        /**out[i] = a[i] + b[i]*/
+        void (*add)(Vector3Span a, Vector3Span b, Vector3MutSpan out, size_t n);
+        /**out[i] = a[i] + b[i] * s*/
+        void (*scaleAdd)(Vector3Span a, Vector3Span b, double s, Vector3MutSpan out, size_t n);
+    };
+}
+#endif //RAYTRACER_C_VEC3_BULK_TABLE_H
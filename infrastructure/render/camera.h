@@ -0,0 +1,94 @@
+#ifndef RAYTRACER_C_CAMERA_H
+#define RAYTRACER_C_CAMERA_H
+
+#include "../math/vec3.h"
+#include "../math/ray.h"
+#include <cmath>
+
+using namespace std;
+namespace bla {
+    /**
+     * A pinhole camera. Screen coordinates run from <code>(0, 0)</code> in the top left
+     * corner of the image to <code>(1, 1)</code> in the bottom right corner.
+     */
+    class Camera {
+    public:
+        /**Position of the camera*/
+        Vector3 eye;
+        /**Point the camera looks at*/
+        Vector3 target;
+        /**Approximate up direction*/
+        Vector3 up;
+        /**Vertical field of view in degrees*/
+        double fov;
+        /**Width divided by height of the image*/
+        double aspect;
+
+        Camera(Vector3 eye = VEC_ZERO, Vector3 target = VEC_K, Vector3 up = VEC_J, double fov = 45.0,
+               double aspect = 1.0)
+                : eye(eye), target(target), up(up), fov(fov), aspect(aspect) {}
+
+        /**
+         * Computes the orthonormal camera basis.
+         *
+         * @param u receives the right vector
+         * @param v receives the up vector
+         * @param w receives the forward vector
+         */
+        void basis(Vector3 &u, Vector3 &v, Vector3 &w) const {
+            w = target - eye;
+            w.norm();
+            u = w.cross(up);
+            u.norm();
+            v = u.cross(w);
+        }
+
+        /**
+         * Creates the ray that passes through a point on the screen.
+         *
+         * @param sx horizontal screen coordinate in <code>[0, 1]</code>
+         * @param sy vertical screen coordinate in <code>[0, 1]</code>
+         * @return the primary ray
+         */
+        Ray3 generateRay(double sx, double sy) const {
+            Vector3 u, v, w;
+            basis(u, v, w);
+
+            double h = tan(fov * M_PI / 360.0);
+            Vector3 d = w + u * ((2.0 * sx - 1.0) * h * aspect) + v * ((1.0 - 2.0 * sy) * h);
+            return Ray3(eye, d);
+        }
+
+        /**
+         * Finds where a point appears on the screen; the inverse of <code>generateRay</code>.
+         *
+         * @param p the point
+         * @param sx receives the horizontal screen coordinate
+         * @param sy receives the vertical screen coordinate
+         * @return <b>false</b> if <b>p</b> is not in front of the camera
+         */
+        bool project(const Vector3 &p, double &sx, double &sy) const {
+            Vector3 u, v, w;
+            basis(u, v, w);
+
+            Vector3 d = p - eye;
+            double z = d * w;
+            if (z <= 0.0)
+                return false;
+
+            double h = tan(fov * M_PI / 360.0);
+            sx = ((d * u) / (z * h * aspect) + 1.0) * 0.5;
+            sy = (1.0 - (d * v) / (z * h)) * 0.5;
+            return true;
+        }
+
+        bool operator==(const Camera &o) const {
+            return eye == o.eye && target == o.target && up == o.up && fov == o.fov && aspect == o.aspect;
+        }
+
+        bool operator!=(const Camera &o) const {
+            return !(*this == o);
+        }
+    };
+}
+#endif //RAYTRACER_C_CAMERA_H
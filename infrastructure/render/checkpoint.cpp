@@ -0,0 +1,387 @@
+/**
+* CheckpointFile and CheckpointRenderer implementation
+*/
+
+#include "checkpoint.h"
+#include "trace.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace bla {
+    namespace {
+        const char MAGIC[8] = {'B', 'L', 'A', 'C', 'K', 'P', 'T', '1'};
+        const uint32_t VERSION = 2;
+
+        size_t pageAlign(size_t n) {
+            size_t page = (size_t) sysconf(_SC_PAGESIZE);
+            return (n + page - 1) / page * page;
+        }
+
+        string systemError(const string &what, const string &path) {
+            return what + " " + path + ": " + strerror(errno);
+        }
+
+        /**
+         * 64 bit FNV-1a over the bytes of the values added to it.
+         */
+        struct Fingerprint {
+            uint64_t h = 0xcbf29ce484222325ULL;
+
+            void add(const void *data, size_t n) {
+                const uint8_t *p = (const uint8_t *) data;
+                for (size_t i = 0; i < n; i++) {
+                    h ^= p[i];
+                    h *= 0x100000001b3ULL;
+                }
+            }
+
+            template<typename T>
+            void add(const T &v) {
+                add(&v, sizeof(v));
+            }
+
+            void add(const Vector3 &v) {
+                add(v.x);
+                add(v.y);
+                add(v.z);
+            }
+        };
+    }
+
+    //=========================
+    //=====CHECKPOINT FILE=====
+    //=========================
+
+    bool CheckpointFile::create(const string &path, string &error) {
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            error = systemError("could not create", path);
+            return false;
+        }
+        // The slots stay sparse until tiles are written to them.
+        if (ftruncate(fd, (off_t) bytes) != 0) {
+            error = systemError("could not size", path);
+            return false;
+        }
+        map = (uint8_t *) mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (map == MAP_FAILED) {
+            map = nullptr;
+            error = systemError("could not map", path);
+            return false;
+        }
+
+        for (uint64_t t = 0; t < header.tiles; t++)
+            table()[t] = t << 32;
+        // The magic goes in last, so a file whose creation was interrupted is not taken for a checkpoint.
+        Header h = header;
+        memset(h.magic, 0, sizeof(h.magic));
+        memcpy(map, &h, sizeof(h));
+        if (msync(map, bytes, MS_SYNC) != 0) {
+            error = systemError("could not write", path);
+            return false;
+        }
+        memcpy(map, &header, sizeof(header));
+        if (msync(map, pageAlign(sizeof(Header)), MS_SYNC) != 0) {
+            error = systemError("could not write", path);
+            return false;
+        }
+        return true;
+    }
+
+    void CheckpointFile::close() {
+        if (map != nullptr)
+            munmap(map, bytes);
+        if (fd >= 0)
+            ::close(fd);
+        map = nullptr;
+        fd = -1;
+    }
+
+    bool CheckpointFile::open(const string &path, const RenderSettings &settings, uint64_t fingerprint,
+                              bool &resumed, string &error) {
+        close();
+        resumed = false;
+
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.recordBytes = sizeof(PixelSums);
+        header.fingerprint = fingerprint;
+        header.width = settings.width;
+        header.height = settings.height;
+        header.spp = settings.spp;
+        header.tileSize = settings.tileSize;
+        header.tiles = makeTiles(settings.renderRegion(), settings.tileSize).size();
+        header.slotBytes = pageAlign((size_t) settings.tileSize * settings.tileSize * sizeof(PixelSums));
+
+        tableOffset = pageAlign(sizeof(Header));
+        tableBytes = pageAlign(header.tiles * sizeof(uint64_t));
+        slotsOffset = tableOffset + tableBytes;
+        bytes = slotsOffset + (header.tiles + SPARE_SLOTS) * header.slotBytes;
+        uint64_t slots = header.tiles + SPARE_SLOTS;
+
+        Header existing;
+        struct stat st;
+        bool found = stat(path.c_str(), &st) == 0 && (size_t) st.st_size >= sizeof(Header);
+        if (found) {
+            fd = ::open(path.c_str(), O_RDWR);
+            if (fd < 0 || pread(fd, &existing, sizeof(existing), 0) != (ssize_t) sizeof(existing)) {
+                error = systemError("could not read", path);
+                close();
+                return false;
+            }
+            char blank[sizeof(MAGIC)] = {};
+            if (memcmp(existing.magic, blank, sizeof(blank)) == 0) {
+                // Creation was interrupted; start over.
+                found = false;
+                close();
+            } else if (memcmp(existing.magic, MAGIC, sizeof(MAGIC)) != 0) {
+                error = path + " is not a checkpoint";
+                close();
+                return false;
+            }
+        }
+
+        if (!found) {
+            spare.clear();
+            for (uint32_t s = (uint32_t) header.tiles; s < slots; s++)
+                spare.push_back(s);
+            if (!create(path, error)) {
+                close();
+                return false;
+            }
+            return true;
+        }
+
+        if (memcmp(&existing, &header, sizeof(Header)) != 0 || (size_t) st.st_size != bytes) {
+            error = path + " is the checkpoint of a different render";
+            close();
+            return false;
+        }
+        map = (uint8_t *) mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (map == MAP_FAILED) {
+            map = nullptr;
+            error = systemError("could not map", path);
+            close();
+            return false;
+        }
+
+        // Every slot not in the table is free.
+        vector<bool> used(slots, false);
+        for (uint64_t t = 0; t < header.tiles; t++) {
+            uint64_t s = table()[t] >> 32;
+            if (s >= slots || used[s] || samples(t) > header.spp) {
+                error = path + " is corrupt";
+                close();
+                return false;
+            }
+            used[s] = true;
+            resumed |= samples(t) > 0;
+        }
+        spare.clear();
+        for (uint32_t s = 0; s < slots; s++) {
+            if (!used[s])
+                spare.push_back(s);
+        }
+        return true;
+    }
+
+    bool CheckpointFile::save(const vector<size_t> &dirty, const vector<vector<PixelSums>> &pixels,
+                              const vector<int> &samples, string &error) {
+        TraceSpan span("checkpoint", "io");
+        for (size_t b = 0; b < dirty.size(); b += spare.size()) {
+            size_t n = min(spare.size(), dirty.size() - b);
+            for (size_t k = 0; k < n; k++) {
+                const vector<PixelSums> &p = pixels[dirty[b + k]];
+                memcpy(slot(spare[k]), p.data(), p.size() * sizeof(PixelSums));
+            }
+            // Only dirty pages are written back, i.e. the slots just filled.
+            if (msync(map, bytes, MS_SYNC) != 0) {
+                error = string("could not write checkpoint: ") + strerror(errno);
+                return false;
+            }
+
+            for (size_t k = 0; k < n; k++) {
+                size_t t = dirty[b + k];
+                uint32_t old = (uint32_t) (table()[t] >> 32);
+                table()[t] = (uint64_t) spare[k] << 32 | (uint32_t) samples[t];
+                spare[k] = old;
+            }
+            if (msync(map + tableOffset, tableBytes, MS_SYNC) != 0) {
+                error = string("could not write checkpoint: ") + strerror(errno);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //=============================
+    //=====CHECKPOINT RENDERER=====
+    //=============================
+
+    uint64_t CheckpointRenderer::fingerprint(const PreparedScene &scene, const Camera &camera,
+                                             const RenderSettings &settings) {
+        Fingerprint f;
+        f.add(settings.width);
+        f.add(settings.height);
+        f.add(settings.spp);
+        f.add(settings.maxDepth);
+        f.add(settings.seed);
+        Tile region = settings.renderRegion();
+        f.add(region.x0);
+        f.add(region.y0);
+        f.add(region.x1);
+        f.add(region.y1);
+
+        f.add(camera.eye);
+        f.add(camera.target);
+        f.add(camera.up);
+        f.add(camera.fov);
+        f.add(camera.aspect);
+
+        f.add(scene.scene.background);
+        for (uint32_t i = 0; i < scene.store.size(); i++) {
+            Vector3 c;
+            double r;
+            scene.store.boundingSphere(i, c, r);
+            f.add(c);
+            f.add(r);
+            f.add(scene.scene.materials[i].albedo);
+            f.add(scene.scene.materials[i].emission);
+        }
+        return f.h;
+    }
+
+    bool CheckpointRenderer::render(const PreparedScene &scene, const Camera &camera, const RenderSettings &settings,
+                                    const string &path, const CheckpointSettings &checkpoint, FrameBuffer &out,
+                                    CheckpointStats &stats, string &error) {
+        auto start = chrono::steady_clock::now();
+        out.resize(settings.width, settings.height);
+        vector<Tile> tiles = makeTiles(settings.renderRegion(), settings.tileSize);
+        stats = CheckpointStats();
+
+        CheckpointFile file;
+        if (!file.open(path, settings, fingerprint(scene, camera, settings), stats.resumed, error))
+            return false;
+
+        vector<vector<PixelSums>> pixels(tiles.size());
+        vector<int> samples(tiles.size());
+        for (size_t t = 0; t < tiles.size(); t++) {
+            size_t area = (size_t) tiles[t].width() * tiles[t].height();
+            pixels[t].assign(file.pixels(t), file.pixels(t) + area);
+            samples[t] = file.samples(t);
+            stats.resumedSamples += area * samples[t];
+        }
+
+        TileBins bins;
+        bool binned = settings.binPrimary && !scene.grid.built();
+        if (binned)
+            bins = TileBins(scene.store, camera, settings.width, settings.height, settings.renderRegion(),
+                            settings.tileSize);
+
+        int threads = resolveThreads(settings.threads);
+        vector<uint64_t> rays((size_t) threads, 0);
+        mutex dirtyLock, saveLock;
+        vector<size_t> dirty;
+        atomic<bool> failed(false);
+        auto lastSave = chrono::steady_clock::now();
+
+        // Called with saveLock held.
+        auto save = [&]() {
+            vector<size_t> batch;
+            {
+                lock_guard<mutex> l(dirtyLock);
+                batch.swap(dirty);
+            }
+            lastSave = chrono::steady_clock::now();
+            if (batch.empty())
+                return;
+            sort(batch.begin(), batch.end());
+            string e;
+            if (!file.save(batch, pixels, samples, e)) {
+                error = e;
+                failed = true;
+            }
+            stats.checkpoints++;
+            stats.tilesWritten += batch.size();
+        };
+        auto stopped = [&]() {
+            return failed || (checkpoint.stop != nullptr && *checkpoint.stop);
+        };
+
+        int passSamples = max(1, checkpoint.passSamples);
+        while (!stopped()) {
+            vector<size_t> todo;
+            for (size_t t = 0; t < tiles.size(); t++) {
+                if (samples[t] < settings.spp)
+                    todo.push_back(t);
+            }
+            if (todo.empty())
+                break;
+
+            // A tile is only touched by the worker that renders it during a pass, and tiles that
+            // finished their pass are not touched again until the next one, so they can be saved
+            // while the other workers carry on.
+            parallelFor(todo.size(), threads, [&](size_t k, int worker) {
+                if (stopped())
+                    return;
+                size_t t = todo[k];
+                const Tile &tile = tiles[t];
+                TraceSpan span("tile pass", "render", tile.index);
+                PrimitiveList candidates = binned ? bins.candidates(tile.index) : PrimitiveList{nullptr, 0};
+                int first = samples[t], last = min(settings.spp, first + passSamples);
+
+                PixelSums *p = pixels[t].data();
+                for (int y = tile.y0; y < tile.y1; y++) {
+                    for (int x = tile.x0; x < tile.x1; x++) {
+                        rays[worker] += Renderer::accumulatePixel(scene, camera, settings, x, y, first, last, *p++,
+                                                                  binned ? &candidates : nullptr);
+                    }
+                }
+                samples[t] = last;
+                {
+                    lock_guard<mutex> l(dirtyLock);
+                    dirty.push_back(t);
+                }
+
+                unique_lock<mutex> l(saveLock, try_to_lock);
+                if (l.owns_lock() &&
+                    chrono::duration<double>(chrono::steady_clock::now() - lastSave).count() >= checkpoint.interval)
+                    save();
+            });
+        }
+        {
+            lock_guard<mutex> l(saveLock);
+            if (!failed)
+                save();
+        }
+        if (failed)
+            return false;
+
+        stats.finished = true;
+        for (size_t t = 0; t < tiles.size(); t++) {
+            stats.finished &= samples[t] == settings.spp;
+            if (samples[t] == 0)
+                continue;
+            const PixelSums *p = pixels[t].data();
+            for (int y = tiles[t].y0; y < tiles[t].y1; y++) {
+                for (int x = tiles[t].x0; x < tiles[t].x1; x++)
+                    out.resolve(out.index(x, y), *p++, samples[t]);
+            }
+        }
+
+        for (uint64_t r : rays)
+            stats.render.rays += r;
+        stats.render.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        return true;
+    }
+}
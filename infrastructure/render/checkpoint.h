@@ -0,0 +1,193 @@
+#ifndef RAYTRACER_C_CHECKPOINT_H
+#define RAYTRACER_C_CHECKPOINT_H
+
+#include "renderer.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+namespace bla {
+    /**
+     * Options for <code>CheckpointRenderer</code>.
+     */
+    struct CheckpointSettings {
+        /**Seconds between checkpoints*/
+        double interval = 30.0;
+        /**Samples per pixel every tile gets per pass; more passes mean finer checkpoints*/
+        int passSamples = 4;
+        /**
+         * If not <code>nullptr</code>, the render stops as soon as this becomes <b>true</b>
+         * (e.g. from a <code>SIGTERM</code> handler) and saves its progress first
+         */
+        const atomic<bool> *stop = nullptr;
+    };
+
+    /**
+     * What a checkpointed render did.
+     */
+    struct CheckpointStats {
+        RenderStats render;
+        /**Whether progress was loaded from an existing checkpoint*/
+        bool resumed = false;
+        /**Pixel samples that were loaded instead of traced*/
+        uint64_t resumedSamples = 0;
+        /**How many times progress was saved*/
+        size_t checkpoints = 0;
+        /**Tiles written over all checkpoints*/
+        size_t tilesWritten = 0;
+        /**Whether every pixel got all its samples, i.e. the render was not stopped*/
+        bool finished = false;
+    };
+
+    /**
+     * The memory mapped file a <code>CheckpointRenderer</code> saves its progress to. It
+     * holds, for every tile, the running sums of every pixel and the number of samples
+     * they cover. The sampler of a pixel sample is determined by the seed, the pixel and
+     * the sample index, so that count is all the sampler state there is.
+     * <p>
+     * The file consists of page aligned parts:
+     * <ul>
+     * <li>a header identifying the render: its size, sample count, tile size and a
+     * fingerprint of the scene, camera and settings;</li>
+     * <li>a table with one 64 bit entry per tile, holding the slot the tile is stored in
+     * (high 32 bits) and its sample count (low 32 bits);</li>
+     * <li>the slots, one per tile plus <code>SPARE_SLOTS</code> spares, each holding the
+     * <code>PixelSums</code> of a tile in row major order.</li>
+     * </ul>
+     * </p>
+     * <p>
+     * Tiles are never overwritten in place. A save copies the tiles that changed into
+     * spare slots, flushes them to disk, and only then points their table entries at the
+     * new slots, which frees the old ones. Only the pages of those slots and of the table
+     * are written. A process killed at any point leaves every tile either at its old or at
+     * its new state; either way its sums match its count.
+     * </p>
+     */
+    class CheckpointFile {
+    public:
+        /**Slots beyond one per tile; one save writes at most this many tiles between flushes*/
+        static const uint32_t SPARE_SLOTS = 64;
+
+    private:
+        struct Header {
+            char magic[8];
+            uint32_t version;
+            uint32_t recordBytes;
+            uint64_t fingerprint;
+            int32_t width, height, spp, tileSize;
+            uint64_t tiles;
+            uint64_t slotBytes;
+        };
+
+        int fd = -1;
+        uint8_t *map = nullptr;
+        size_t bytes = 0;
+        Header header;
+        size_t tableOffset = 0, slotsOffset = 0, tableBytes = 0;
+        vector<uint32_t> spare;
+
+        uint64_t *table() const {
+            return (uint64_t *) (map + tableOffset);
+        }
+
+        PixelSums *slot(uint32_t s) const {
+            return (PixelSums *) (map + slotsOffset + s * header.slotBytes);
+        }
+
+        bool create(const string &path, string &error);
+
+        void close();
+
+    public:
+        CheckpointFile() {}
+
+        CheckpointFile(const CheckpointFile &) = delete;
+
+        CheckpointFile &operator=(const CheckpointFile &) = delete;
+
+        ~CheckpointFile() {
+            close();
+        }
+
+        /**
+         * Opens the checkpoint of a render, creating an empty one if <b>path</b> does not
+         * exist yet.
+         *
+         * @param path the checkpoint file
+         * @param settings the render; its tiles are <code>makeTiles(settings.renderRegion(), settings.tileSize)</code>
+         * @param fingerprint identifies the scene, camera and settings; see <code>CheckpointRenderer::fingerprint</code>
+         * @param resumed receives whether the file already held progress
+         * @param error receives the reason if the file can not be used, e.g. because it
+         *              belongs to a different render
+         * @return <b>true</b> on success
+         */
+        bool open(const string &path, const RenderSettings &settings, uint64_t fingerprint, bool &resumed,
+                  string &error);
+
+        /**
+         * @return the number of samples per pixel stored for tile <b>t</b>
+         */
+        int samples(size_t t) const {
+            return (int) (table()[t] & 0xffffffffu);
+        }
+
+        /**
+         * @return the stored sums of the pixels of tile <b>t</b>, in row major order
+         */
+        const PixelSums *pixels(size_t t) const {
+            return slot((uint32_t) (table()[t] >> 32));
+        }
+
+        /**
+         * Saves some of the tiles, see above.
+         *
+         * @param dirty the indices of the tiles to save
+         * @param pixels the sums of the pixels of every tile, in row major order
+         * @param samples the sample count of every tile
+         * @param error receives the reason if writing failed
+         * @return <b>true</b> on success
+         */
+        bool save(const vector<size_t> &dirty, const vector<vector<PixelSums>> &pixels, const vector<int> &samples,
+                  string &error);
+    };
+
+    /**
+     * Renders an image progressively while saving its progress to a
+     * <code>CheckpointFile</code>, so that a render that was interrupted (say, because
+     * its machine was pre-empted) continues where the last checkpoint left off.
+     * <p>
+     * Every pass adds <code>CheckpointSettings::passSamples</code> samples to every tile
+     * that still needs them. Whenever a tile finishes a pass and
+     * <code>CheckpointSettings::interval</code> seconds have gone by since the last
+     * save, the worker that finished it saves every tile that changed since. Samples are
+     * added to each pixel in the same order however the work was split up, so a resumed
+     * render is bit for bit the same as an uninterrupted one, and as
+     * <code>Renderer::render</code>.
+     * </p>
+     */
+    class CheckpointRenderer {
+    public:
+        /**
+         * Renders <b>scene</b>, resuming from the checkpoint at <b>path</b> if there is one.
+         * If the render is stopped, <b>out</b> holds every tile averaged over the samples
+         * it got so far.
+         *
+         * @param stats receives what was traced, loaded and saved
+         * @param error receives the reason if the checkpoint could not be read or written
+         * @return <b>true</b> unless the checkpoint failed; check
+         *         <code>CheckpointStats::finished</code> for whether the image is complete
+         */
+        static bool render(const PreparedScene &scene, const Camera &camera, const RenderSettings &settings,
+                           const string &path, const CheckpointSettings &checkpoint, FrameBuffer &out,
+                           CheckpointStats &stats, string &error);
+
+        /**
+         * @return a hash of everything the image depends on: the traced geometry and the
+         * materials of the scene, the camera and the settings
+         */
+        static uint64_t fingerprint(const PreparedScene &scene, const Camera &camera, const RenderSettings &settings);
+    };
+}
+#endif //RAYTRACER_C_CHECKPOINT_H
@@ -0,0 +1,31 @@
+#ifndef RAYTRACER_C_COLOR_H
+#define RAYTRACER_C_COLOR_H
+
+#include "../math/vec3.h"
+
+using namespace std;
+namespace bla {
+    // Vector3 only has the geometric products; colors also need the component-wise ones.
+
+    /**
+     * @return the component-wise product of <b>a</b> and <b>b</b>
+     */
+    inline Vector3 mulColor(const Vector3 &a, const Vector3 &b) {
+        return Vector3(a.x * b.x, a.y * b.y, a.z * b.z);
+    }
+
+    /**
+     * @return the component-wise quotient of <b>a</b> and <b>b</b>, treating tiny denominators as <b>eps</b>
+     */
+    inline Vector3 divColor(const Vector3 &a, const Vector3 &b, double eps = 1e-3) {
+        return Vector3(a.x / (b.x > eps ? b.x : eps), a.y / (b.y > eps ? b.y : eps), a.z / (b.z > eps ? b.z : eps));
+    }
+
+    /**
+     * @return the Rec. 709 luminance of a linear color
+     */
+    inline double luminance(const Vector3 &c) {
+        return 0.2126 * c.x + 0.7152 * c.y + 0.0722 * c.z;
+    }
+}
+#endif //RAYTRACER_C_COLOR_H
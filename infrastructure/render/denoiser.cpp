@@ -0,0 +1,145 @@
+/**
+* Denoiser implementation
+*/
+
+#include "denoiser.h"
+#include "color.h"
+#include "tiles.h"
+#include "trace.h"
+#include <cmath>
+#include <cstdint>
+
+using namespace std;
+
+namespace bla {
+    namespace {
+        /**The 1D B3-spline kernel; the 5x5 kernel is its outer product.*/
+        const double kernel[5] = {1.0 / 16.0, 1.0 / 4.0, 3.0 / 8.0, 1.0 / 4.0, 1.0 / 16.0};
+        /**Albedo below which a pixel has no reflected light to demodulate, so it is not filtered*/
+        const double MIN_ALBEDO = 1e-3;
+
+        /**
+         * The buffers one à-trous pass reads from or writes to.
+         */
+        struct Level {
+            vector<Vector3> color;
+            vector<double> variance;
+
+            explicit Level(size_t n) : color(n), variance(n) {}
+        };
+
+        /**
+         * @return the variance at <code>(x, y)</code> blurred with a 3x3 Gaussian, which is far
+         * less noisy than the per-pixel estimate
+         */
+        double blurredVariance(const FrameBuffer &aov, const vector<double> &variance, int x, int y) {
+            static const double g[2] = {1.0 / 4.0, 1.0 / 8.0};
+            double sum = 0.0, wsum = 0.0;
+
+            for (int j = -1; j <= 1; j++) {
+                for (int i = -1; i <= 1; i++) {
+                    int qx = x + i, qy = y + j;
+                    if (qx < 0 || qy < 0 || qx >= aov.width || qy >= aov.height)
+                        continue;
+                    double w = g[abs(i)] * g[abs(j)] * 4.0;
+                    sum += variance[aov.index(qx, qy)] * w;
+                    wsum += w;
+                }
+            }
+            return sum / wsum;
+        }
+
+        /**
+         * Runs one à-trous pass over a tile.
+         */
+        void filterTile(const FrameBuffer &aov, const vector<uint8_t> &filtered, const Level &src, Level &dst,
+                        const Tile &tile, int step, const DenoiseSettings &settings) {
+            int w = aov.width, h = aov.height;
+            double invNormal = 1.0 / (settings.sigmaNormal * settings.sigmaNormal);
+            double invDepth = 1.0 / (settings.sigmaDepth * step);
+
+            for (int y = tile.y0; y < tile.y1; y++) {
+                for (int x = tile.x0; x < tile.x1; x++) {
+                    size_t p = aov.index(x, y);
+                    if (!filtered[p]) {
+                        dst.color[p] = src.color[p];
+                        dst.variance[p] = src.variance[p];
+                        continue;
+                    }
+                    double lp = luminance(src.color[p]);
+                    const Vector3 &np = aov.normal[p];
+                    double zp = aov.depth[p];
+                    // Luminance differences are measured in standard deviations of the remaining noise.
+                    double invColor = 1.0 / (settings.sigmaColor * sqrt(blurredVariance(aov, src.variance, x, y)) + 1e-4);
+
+                    Vector3 sum = VEC_ZERO;
+                    double wsum = 0.0, vsum = 0.0;
+
+                    for (int j = -2; j <= 2; j++) {
+                        int qy = y + j * step;
+                        if (qy < 0 || qy >= h)
+                            continue;
+                        for (int i = -2; i <= 2; i++) {
+                            int qx = x + i * step;
+                            if (qx < 0 || qx >= w)
+                                continue;
+                            size_t q = aov.index(qx, qy);
+                            if (!filtered[q])
+                                continue;
+
+                            double dl = fabs(luminance(src.color[q]) - lp);
+                            double dn = (aov.normal[q] - np).sqr();
+                            double dz = fabs(aov.depth[q] - zp) / (zp > 1e-3 ? zp : 1e-3);
+
+                            double weight = kernel[i + 2] * kernel[j + 2] *
+                                            exp(-dl * invColor - dn * invNormal - dz * invDepth);
+                            sum += src.color[q] * weight;
+                            vsum += src.variance[q] * weight * weight;
+                            wsum += weight;
+                        }
+                    }
+
+                    // The center tap always has weight kernel[2]^2 > 0, so wsum is never 0.
+                    dst.color[p] = sum * (1.0 / wsum);
+                    dst.variance[p] = vsum / (wsum * wsum);
+                }
+            }
+        }
+    }
+
+    void Denoiser::denoise(const FrameBuffer &in, const DenoiseSettings &settings, vector<Vector3> &out) {
+        TraceSpan span("denoise", "post");
+        size_t n = in.size();
+        Level a(n), b(n);
+        // Emitted light is not reflected, so it is left out of the demodulated signal and added
+        // back afterwards; pixels that reflect nothing, such as the face of a light, are left alone.
+        vector<uint8_t> filtered(n);
+        for (size_t i = 0; i < n; i++) {
+            const Vector3 &albedo = in.albedo[i];
+            filtered[i] = max(albedo.x, max(albedo.y, albedo.z)) >= MIN_ALBEDO;
+            a.color[i] = divColor(in.color[i] - in.emission[i], albedo, MIN_ALBEDO);
+            double l = max(luminance(albedo), MIN_ALBEDO);
+            a.variance[i] = in.variance[i] / (l * l);
+        }
+
+        vector<Tile> tiles = makeTiles(in.width, in.height, settings.tileSize);
+
+        for (int it = 0; it < settings.iterations; it++) {
+            int step = 1 << it;
+            parallelFor(tiles.size(), settings.threads, [&](size_t t, int) {
+                filterTile(in, filtered, a, b, tiles[t], step, settings);
+            });
+            swap(a, b);
+        }
+
+        out.resize(n);
+        for (size_t i = 0; i < n; i++)
+            out[i] = filtered[i] ? mulColor(a.color[i], in.albedo[i]) + in.emission[i] : in.color[i];
+    }
+
+    void Denoiser::denoise(FrameBuffer &fb, const DenoiseSettings &settings) {
+        vector<Vector3> out;
+        denoise(fb, settings, out);
+        fb.color.swap(out);
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef RAYTRACER_C_DENOISER_H
+#define RAYTRACER_C_DENOISER_H
+
+#include "framebuffer.h"
+#include <vector>
+
+using namespace std;
+namespace bla {
+    /**
+     * Options for the <code>Denoiser</code>.
+     */
+    struct DenoiseSettings {
+        /**Number of à-trous passes; pass <i>i</i> samples pixels <code>2^i</code> apart*/
+        int iterations = 5;
+        /**How many standard deviations of noise a luminance difference may span before a neighbour stops contributing*/
+        double sigmaColor = 4.0;
+        /**How much normal difference is tolerated*/
+        double sigmaNormal = 0.3;
+        /**How much relative depth difference is tolerated*/
+        double sigmaDepth = 0.1;
+        /**Edge length of the tiles the work is split into*/
+        int tileSize = 32;
+        /**Number of worker threads, or 0 for one per hardware thread*/
+        int threads = 0;
+    };
+
+    /**
+     * An edge-avoiding à-trous wavelet denoiser (Dammertz et al. 2010). Each pass blurs
+     * with a 5x5 B3-spline kernel whose taps are spread further apart every pass, and
+     * every tap is weighted down where the color, normal or depth differ from the center
+     * pixel, so edges and geometric detail survive the blur. The color test is scaled by
+     * the per-pixel variance the renderer reports (as in SVGF), so noisy pixels are blurred
+     * hard while converged ones are left alone.
+     * <p>
+     * The filter runs on the color divided by the albedo, so texture detail is restored
+     * exactly when the albedo is multiplied back in. Light emitted by the first hit is taken
+     * out before and added back after, and pixels with no albedo to divide by, such as a
+     * directly visible light, are passed through unfiltered and ignored by their neighbours.
+     * </p>
+     *
+     * @see <a href="https://jo.dreggn.org/home/2010_atrous.pdf">Edge-Avoiding À-Trous Wavelet Transform</a>
+     */
+    class Denoiser {
+    public:
+        /**
+         * Denoises the color buffer of a <code>FrameBuffer</code>.
+         *
+         * @param in the noisy image and its AOVs
+         * @param settings the filter options
+         * @param out receives the filtered color; resized to match <b>in</b>
+         */
+        static void denoise(const FrameBuffer &in, const DenoiseSettings &settings, vector<Vector3> &out);
+
+        /**
+         * Denoises a <code>FrameBuffer</code> in place.
+         */
+        static void denoise(FrameBuffer &fb, const DenoiseSettings &settings);
+    };
+}
+#endif //RAYTRACER_C_DENOISER_H
@@ -0,0 +1,89 @@
+#ifndef RAYTRACER_C_FRAMEBUFFER_H
+#define RAYTRACER_C_FRAMEBUFFER_H
+
+#include "../math/vec3.h"
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+namespace bla {
+    /**
+     * Running sums over the samples of one pixel, from which
+     * <code>FrameBuffer::resolve</code> produces the pixel's output.
+     */
+    struct PixelSums {
+        Vector3 color;
+        Vector3 albedo;
+        Vector3 emission;
+        Vector3 normal;
+        double depth = 0.0;
+        /**Sum of the luminance of the samples*/
+        double lum = 0.0;
+        /**Sum of the squared luminance of the samples*/
+        double lum2 = 0.0;
+    };
+
+    /**
+     * The output of a render: the color image plus the auxiliary buffers (AOVs) the
+     * renderer writes next to it. The AOVs describe the first surface seen through
+     * each pixel, averaged over the pixel's samples, and are what the denoiser uses
+     * to tell edges apart from noise.
+     */
+    class FrameBuffer {
+    public:
+        int width;
+        int height;
+        /**Radiance*/
+        vector<Vector3> color;
+        /**Albedo of the first hit (the background counts as white)*/
+        vector<Vector3> albedo;
+        /**Light emitted by the first hit, which is part of <b>color</b>*/
+        vector<Vector3> emission;
+        /**Normal of the first hit (zero for the background)*/
+        vector<Vector3> normal;
+        /**Distance to the first hit (zero for the background)*/
+        vector<double> depth;
+        /**Variance of the luminance of <b>color</b>, i.e. how noisy each pixel still is*/
+        vector<double> variance;
+
+        FrameBuffer(int width = 0, int height = 0) {
+            resize(width, height);
+        }
+
+        void resize(int w, int h) {
+            width = w;
+            height = h;
+            size_t n = (size_t) w * h;
+            color.assign(n, VEC_ZERO);
+            albedo.assign(n, VEC_ZERO);
+            emission.assign(n, VEC_ZERO);
+            normal.assign(n, VEC_ZERO);
+            depth.assign(n, 0.0);
+            variance.assign(n, 0.0);
+        }
+
+        size_t size() const {
+            return color.size();
+        }
+
+        size_t index(int x, int y) const {
+            return (size_t) y * width + x;
+        }
+
+        /**
+         * Writes the average of <b>count</b> samples to pixel <b>i</b>.
+         */
+        void resolve(size_t i, const PixelSums &sums, int count) {
+            double inv = 1.0 / count;
+            color[i] = sums.color * inv;
+            albedo[i] = sums.albedo * inv;
+            emission[i] = sums.emission * inv;
+            normal[i] = sums.normal * inv;
+            depth[i] = sums.depth * inv;
+            // Variance of the pixel mean: the sample variance divided by the sample count.
+            double mean = sums.lum * inv;
+            variance[i] = max(0.0, sums.lum2 * inv - mean * mean) * inv;
+        }
+    };
+}
+#endif //RAYTRACER_C_FRAMEBUFFER_H
@@ -0,0 +1,113 @@
+#ifndef RAYTRACER_C_GBUFFER_H
+#define RAYTRACER_C_GBUFFER_H
+
+#include "camera.h"
+#include "tiles.h"
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+namespace bla {
+    /**
+     * The first hit of one camera sample, as stored by <code>GBufferCache</code>.
+     * Position, normal and surface coordinates all follow from the distance and the
+     * primitive, so only those are kept.
+     */
+    struct PrimaryHit {
+        /**Distance along the camera ray*/
+        double t;
+        /**Index of the primitive that was hit, or -1*/
+        int32_t prim;
+    };
+
+    /**
+     * Everything the first hits of a render depend on. Materials and lights are
+     * deliberately not part of it.
+     */
+    struct GBufferKey {
+        Camera camera;
+        int width = 0;
+        int height = 0;
+        int spp = 0;
+        uint64_t seed = 0;
+        Tile region = {0, 0, 0, 0, 0};
+        size_t primitives = 0;
+        /**<code>PrimitiveStore::getGeometryHash()</code> of the scene the hits were traced in*/
+        uint64_t geometry = 0;
+
+        bool operator==(const GBufferKey &o) const {
+            return camera == o.camera && width == o.width && height == o.height && spp == o.spp &&
+                   seed == o.seed && region.x0 == o.region.x0 && region.y0 == o.region.y0 &&
+                   region.x1 == o.region.x1 && region.y1 == o.region.y1 && primitives == o.primitives &&
+                   geometry == o.geometry;
+        }
+
+        bool operator!=(const GBufferKey &o) const {
+            return !(*this == o);
+        }
+    };
+
+    /**
+     * The first hit of every camera sample of a render, kept so that renders which only
+     * change materials or lights can skip primary visibility and go straight to shading.
+     * Pass the same cache to consecutive <code>Renderer::render</code> calls; the renderer
+     * fills it on the first and replays it as long as the key still matches.
+     * <p>
+     * Any change to the camera or the render resolution, and any change to the geometry of
+     * the scene, invalidates the cache. Geometry is compared through the packed primitives of
+     * the <code>PreparedScene</code>, so it does not matter how a sphere was moved, and work
+     * on other scenes or objects leaves the cache alone.
+     * </p>
+     */
+    class GBufferCache {
+    private:
+        GBufferKey key;
+        bool valid = false;
+        vector<PrimaryHit> hits;
+
+    public:
+        /**
+         * @return <b>true</b> if the cache holds the hits for <b>k</b>
+         */
+        bool matches(const GBufferKey &k) const {
+            return valid && key == k;
+        }
+
+        /**
+         * Empties the cache and sizes it for a render with key <b>k</b>. It becomes valid
+         * once <code>validate()</code> is called after every hit has been stored.
+         */
+        void reset(const GBufferKey &k) {
+            key = k;
+            valid = false;
+            hits.assign((size_t) k.width * k.height * k.spp, PrimaryHit{0.0, -1});
+        }
+
+        void validate() {
+            valid = true;
+        }
+
+        void invalidate() {
+            valid = false;
+        }
+
+        /**
+         * @return the stored hit of sample <b>sample</b> of the pixel with index <b>pixel</b>
+         */
+        PrimaryHit &at(size_t pixel, int sample) {
+            return hits[pixel * key.spp + sample];
+        }
+
+        const PrimaryHit &at(size_t pixel, int sample) const {
+            return hits[pixel * key.spp + sample];
+        }
+
+        /**
+         * @return bytes used by the stored hits
+         */
+        size_t memoryUsage() const {
+            return hits.size() * sizeof(PrimaryHit);
+        }
+    };
+}
+#endif //RAYTRACER_C_GBUFFER_H
@@ -0,0 +1,85 @@
+/**
+* PPM reading and writing
+*/
+
+#include "image.h"
+#include "trace.h"
+#include <cmath>
+#include <cctype>
+#include <fstream>
+#include <limits>
+
+using namespace std;
+
+namespace bla {
+    namespace {
+        unsigned char encode(double v) {
+            v = v < 0.0 ? 0.0 : (v > 1.0 ? 1.0 : v);
+            return (unsigned char) lround(pow(v, 1.0 / 2.2) * 255.0);
+        }
+
+        double decode(unsigned char v, int maxValue) {
+            return pow((double) v / maxValue, 2.2);
+        }
+
+        /**
+         * Reads the next number of a PPM header, skipping whitespace and comments.
+         */
+        bool readHeaderValue(istream &in, int &value) {
+            for (int c = in.peek(); c != EOF; c = in.peek()) {
+                if (c == '#')
+                    in.ignore(numeric_limits<streamsize>::max(), '\n');
+                else if (isspace(c))
+                    in.get();
+                else
+                    break;
+            }
+            return (bool) (in >> value);
+        }
+    }
+
+    bool writePPM(const string &path, const vector<Vector3> &pixels, int width, int height) {
+        TraceSpan span("write ppm", "io");
+        ofstream out(path, ios::binary);
+        if (!out)
+            return false;
+
+        out << "P6\n" << width << " " << height << "\n255\n";
+        vector<unsigned char> row((size_t) width * 3);
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                const Vector3 &c = pixels[(size_t) y * width + x];
+                row[3 * x] = encode(c.x);
+                row[3 * x + 1] = encode(c.y);
+                row[3 * x + 2] = encode(c.z);
+            }
+            out.write((const char *) row.data(), row.size());
+        }
+        return (bool) out;
+    }
+
+    bool readPPM(const string &path, vector<Vector3> &pixels, int &width, int &height) {
+        ifstream in(path, ios::binary);
+        char magic[2];
+        if (!in.read(magic, 2) || magic[0] != 'P' || magic[1] != '6')
+            return false;
+
+        int maxValue;
+        if (!readHeaderValue(in, width) || !readHeaderValue(in, height) || !readHeaderValue(in, maxValue))
+            return false;
+        if (width <= 0 || height <= 0 || maxValue <= 0 || maxValue > 255)
+            return false;
+        // Exactly one whitespace character separates the header from the pixels.
+        in.get();
+
+        vector<unsigned char> data((size_t) width * height * 3);
+        if (!in.read((char *) data.data(), data.size()))
+            return false;
+
+        pixels.resize((size_t) width * height);
+        for (size_t i = 0; i < pixels.size(); i++)
+            pixels[i] = Vector3(decode(data[3 * i], maxValue), decode(data[3 * i + 1], maxValue),
+                                decode(data[3 * i + 2], maxValue));
+        return true;
+    }
+}
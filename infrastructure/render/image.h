@@ -0,0 +1,31 @@
+#ifndef RAYTRACER_C_IMAGE_H
+#define RAYTRACER_C_IMAGE_H
+
+#include "../math/vec3.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+namespace bla {
+    /**
+     * Writes linear radiance to a binary PPM (P6) file, clamped and gamma corrected.
+     *
+     * @param path the file to write
+     * @param pixels <code>width * height</code> colors in row major order
+     * @return <b>true</b> on success
+     */
+    bool writePPM(const string &path, const vector<Vector3> &pixels, int width, int height);
+
+    /**
+     * Reads a binary PPM (P6) file with at most 8 bits per channel, undoing the gamma
+     * correction of <code>writePPM</code>.
+     *
+     * @param path the file to read
+     * @param pixels receives <code>width * height</code> linear colors in row major order
+     * @param width receives the image width
+     * @param height receives the image height
+     * @return <b>true</b> on success
+     */
+    bool readPPM(const string &path, vector<Vector3> &pixels, int &width, int &height);
+}
+#endif //RAYTRACER_C_IMAGE_H
@@ -0,0 +1,170 @@
+/**
+* LightBVH implementation
+*/
+
+#include "light_bvh.h"
+#include "color.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace bla {
+    namespace {
+        Vector3 vmin(const Vector3 &a, const Vector3 &b) {
+            return Vector3(min(a.x, b.x), min(a.y, b.y), min(a.z, b.z));
+        }
+
+        Vector3 vmax(const Vector3 &a, const Vector3 &b) {
+            return Vector3(max(a.x, b.x), max(a.y, b.y), max(a.z, b.z));
+        }
+
+        double axis(const Vector3 &v, int a) {
+            return a == 0 ? v.x : (a == 1 ? v.y : v.z);
+        }
+    }
+
+    LightBounds LightBVH::boundsOf(const Vector3 &c, double r, const Material &m, int prim) {
+        Vector3 extent(r, r, r);
+        // A sphere emitting L everywhere gives off 4 pi^2 r^2 L; the constant does not matter here.
+        return LightBounds{c - extent, c + extent, luminance(m.emission) * r * r, prim};
+    }
+
+    LightBVH::LightBVH(const PrimitiveStore &store, const vector<Material> &materials) {
+        TraceSpan span("light bvh", "build");
+        vector<LightBounds> lights;
+        for (uint32_t i = 0; i < store.size(); i++) {
+            if (materials[i].isEmissive()) {
+                Vector3 c;
+                double r;
+                store.boundingSphere(i, c, r);
+                lights.push_back(boundsOf(c, r, materials[i], (int) i));
+            }
+        }
+        *this = LightBVH(lights, store.size());
+    }
+
+    LightBVH::LightBVH(vector<LightBounds> lights, size_t primCount) : leafOf(primCount, -1) {
+        // Lights that are too dim to ever be picked would only make the tree deeper.
+        lights.erase(remove_if(lights.begin(), lights.end(), [](const LightBounds &l) {
+            return !(l.power > 0.0);
+        }), lights.end());
+
+        if (lights.empty())
+            return;
+        nodes.reserve(2 * lights.size() - 1);
+        build(lights, 0, lights.size(), -1);
+    }
+
+    int LightBVH::build(vector<LightBounds> &lights, size_t begin, size_t end, int parent) {
+        int index = (int) nodes.size();
+        nodes.push_back(Node());
+
+        if (end - begin == 1) {
+            const LightBounds &l = lights[begin];
+            nodes[index] = Node{l.lo, l.hi, l.power, -1, -1, parent, l.prim};
+            leafOf[l.prim] = index;
+            return index;
+        }
+
+        // Split at the median of the longest axis of the centroid bounds.
+        Vector3 clo = (lights[begin].lo + lights[begin].hi) * 0.5, chi = clo;
+        for (size_t i = begin + 1; i < end; i++) {
+            Vector3 c = (lights[i].lo + lights[i].hi) * 0.5;
+            clo = vmin(clo, c);
+            chi = vmax(chi, c);
+        }
+        Vector3 extent = chi - clo;
+        int a = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+        size_t mid = begin + (end - begin) / 2;
+        nth_element(lights.begin() + begin, lights.begin() + mid, lights.begin() + end,
+                    [a](const LightBounds &l, const LightBounds &r) {
+                        return axis(l.lo + l.hi, a) < axis(r.lo + r.hi, a);
+                    });
+
+        int left = build(lights, begin, mid, index);
+        int right = build(lights, mid, end, index);
+
+        Node &n = nodes[index];
+        n.lo = vmin(nodes[left].lo, nodes[right].lo);
+        n.hi = vmax(nodes[left].hi, nodes[right].hi);
+        n.power = nodes[left].power + nodes[right].power;
+        n.left = left;
+        n.right = right;
+        n.parent = parent;
+        n.prim = -1;
+        return index;
+    }
+
+    double LightBVH::importance(int node, const Vector3 &p, const Vector3 &n) const {
+        const Node &b = nodes[node];
+        Vector3 c = (b.lo + b.hi) * 0.5;
+        Vector3 d = c - p;
+        double dist2 = d.sqr();
+        double r2 = (b.hi - b.lo).sqr() * 0.25;
+
+        // Inside the bounding sphere anything goes: no cosine bound, and clamp the distance.
+        if (dist2 <= r2)
+            return b.power / max(r2, 1e-12);
+
+        // The box is seen within a cone of half angle alpha around d; bound the receiver's
+        // cosine by the angle between n and the closest direction in that cone.
+        double dist = sqrt(dist2);
+        double cosTheta = max(-1.0, min(1.0, (d * n) / dist));
+        double alpha = asin(min(1.0, sqrt(r2 / dist2)));
+        double theta = max(0.0, acos(cosTheta) - alpha);
+        if (theta >= M_PI / 2.0)
+            return 0.0;
+
+        return b.power * cos(theta) / max(dist2, r2);
+    }
+
+    LightChoice LightBVH::sample(const Vector3 &p, const Vector3 &n, double u) const {
+        LightChoice choice;
+        if (nodes.empty())
+            return choice;
+
+        int node = 0;
+        double pmf = 1.0;
+        while (nodes[node].prim < 0) {
+            double wl = importance(nodes[node].left, p, n);
+            double wr = importance(nodes[node].right, p, n);
+            if (wl + wr <= 0.0)
+                return choice;
+
+            // Reuse u for the next level by rescaling the part of [0, 1) that was chosen.
+            double pl = wl / (wl + wr);
+            if (u < pl) {
+                node = nodes[node].left;
+                pmf *= pl;
+                u = min(u / pl, 1.0 - 1e-16);
+            } else {
+                node = nodes[node].right;
+                pmf *= 1.0 - pl;
+                u = min((u - pl) / (1.0 - pl), 1.0 - 1e-16);
+            }
+        }
+
+        choice.prim = nodes[node].prim;
+        choice.pmf = pmf;
+        return choice;
+    }
+
+    double LightBVH::pmf(const Vector3 &p, const Vector3 &n, int prim) const {
+        if (prim < 0 || prim >= (int) leafOf.size() || leafOf[prim] < 0)
+            return 0.0;
+
+        double pmf = 1.0;
+        for (int node = leafOf[prim]; nodes[node].parent >= 0; node = nodes[node].parent) {
+            const Node &parent = nodes[nodes[node].parent];
+            double wl = importance(parent.left, p, n);
+            double wr = importance(parent.right, p, n);
+            if (wl + wr <= 0.0)
+                return 0.0;
+            pmf *= (node == parent.left ? wl : wr) / (wl + wr);
+        }
+        return pmf;
+    }
+}
@@ -0,0 +1,120 @@
+#ifndef RAYTRACER_C_LIGHT_BVH_H
+#define RAYTRACER_C_LIGHT_BVH_H
+
+#include "primitive_store.h"
+#include "scene.h"
+#include <vector>
+
+using namespace std;
+namespace bla {
+    /**
+     * What the light hierarchy needs to know about one emitter: its bounds and how much
+     * light it gives off. Emitters of any shape can be described this way.
+     */
+    struct LightBounds {
+        /**Lower corner of the emitter's bounding box*/
+        Vector3 lo;
+        /**Upper corner of the emitter's bounding box*/
+        Vector3 hi;
+        /**Total emitted power, up to a constant factor shared by all emitters*/
+        double power;
+        /**Index of the emitting primitive in the <code>Scene</code>*/
+        int prim;
+    };
+
+    /**
+     * A light picked by <code>LightBVH::sample</code>.
+     */
+    struct LightChoice {
+        /**Index of the emitting primitive, or -1 if no light can reach the shading point*/
+        int prim = -1;
+        /**Probability that this light was picked*/
+        double pmf = 0.0;
+    };
+
+    /**
+     * A bounding volume hierarchy over the emitters of a scene, used to pick a light for
+     * next event estimation in time logarithmic in the number of lights (Conty Estevez and
+     * Kulla 2018, without orientation cones since spheres emit in every direction).
+     * <p>
+     * Each node stores the bounds and total power of the emitters below it. Sampling walks
+     * from the root to a leaf, choosing each child with probability proportional to an
+     * estimate of how much it lights the shading point: its power times a bound on the
+     * cosine at the receiver, divided by the squared distance.
+     * </p>
+     */
+    class LightBVH {
+    private:
+        struct Node {
+            Vector3 lo;
+            Vector3 hi;
+            double power;
+            /**Children of an inner node; -1 in leaves*/
+            int left, right;
+            int parent;
+            /**The emitter of a leaf; -1 in inner nodes*/
+            int prim;
+        };
+
+        vector<Node> nodes;
+        /**Leaf node of every primitive, or -1 for primitives that do not emit*/
+        vector<int> leafOf;
+
+        int build(vector<LightBounds> &lights, size_t begin, size_t end, int parent);
+
+        double importance(int node, const Vector3 &p, const Vector3 &n) const;
+
+    public:
+        LightBVH() {}
+
+        /**
+         * Builds the hierarchy over every emissive primitive of a scene, with the geometry
+         * rays are traced against.
+         *
+         * @param store the packed primitives
+         * @param materials the material of every primitive
+         */
+        LightBVH(const PrimitiveStore &store, const vector<Material> &materials);
+
+        /**
+         * Builds the hierarchy over a list of emitters.
+         *
+         * @param lights the emitters; reordered during the build
+         * @param primCount the number of primitives in the scene
+         */
+        LightBVH(vector<LightBounds> lights, size_t primCount);
+
+        bool empty() const {
+            return nodes.empty();
+        }
+
+        /**
+         * @return the number of emitters in the hierarchy
+         */
+        size_t size() const {
+            return nodes.empty() ? 0 : (nodes.size() + 1) / 2;
+        }
+
+        /**
+         * Picks a light for a shading point.
+         *
+         * @param p the shading point
+         * @param n the surface normal at <b>p</b>, on the side the light should come from
+         * @param u a uniform random number in <code>[0, 1)</code>
+         * @return the chosen light and its probability
+         */
+        LightChoice sample(const Vector3 &p, const Vector3 &n, double u) const;
+
+        /**
+         * @return the probability that <code>sample(p, n, u)</code> picks primitive <b>prim</b>
+         */
+        double pmf(const Vector3 &p, const Vector3 &n, int prim) const;
+
+        /**
+         * @return the bounds and power of a sphere around <b>c</b> with radius <b>r</b>, for
+         * building the hierarchy
+         */
+        static LightBounds boundsOf(const Vector3 &c, double r, const Material &m, int prim);
+    };
+}
+#endif //RAYTRACER_C_LIGHT_BVH_H
@@ -0,0 +1,80 @@
+#ifndef RAYTRACER_C_PREPARED_SCENE_H
+#define RAYTRACER_C_PREPARED_SCENE_H
+
+#include "light_bvh.h"
+#include "primitive_store.h"
+#include "scene.h"
+#include "uniform_grid.h"
+
+using namespace std;
+namespace bla {
+    /**
+     * A <code>Scene</code> together with the acceleration structures the renderer builds
+     * for it. Building these is the expensive part of loading a scene, so anything that
+     * renders the same scene many times should prepare it once and keep it around.
+     * <p>
+     * The <code>Scene</code> is referenced, not copied, and must not change while the
+     * <code>PreparedScene</code> is in use. Its spheres are only read while preparing: from
+     * then on <b>store</b> is the only geometry anything traces, samples or hashes, and only
+     * the materials and the background of the <code>Scene</code> are used. Owners that keep
+     * a scene prepared for long may drop its spheres, as the render server does.
+     * </p>
+     */
+    class PreparedScene {
+    public:
+        const Scene &scene;
+        /**Packed copy of the geometry; this is what rays are traced against*/
+        PrimitiveStore store;
+        /**Hierarchy over the emissive primitives, for next event estimation*/
+        LightBVH lights;
+        /**Spatial index over <b>store</b>; not built if every primitive is tested instead*/
+        UniformGrid grid;
+
+        /**
+         * @param scene the scene
+         * @param accelerator how rays find the primitives they can hit
+         * @param threads worker threads for building the accelerator, or 0 for one per hardware thread
+         */
+        explicit PreparedScene(const Scene &scene, Accelerator accelerator = Accelerator::Auto, int threads = 0)
+                : scene(scene), store(scene), lights(store, scene.materials) {
+            GridSettings settings;
+            settings.threads = threads;
+            if (accelerator == Accelerator::Grid ||
+                (accelerator == Accelerator::Auto && UniformGrid::suits(store, settings)))
+                grid = UniformGrid(store, settings);
+        }
+
+        /**
+         * Finds the closest intersection along a ray. Only <b>t</b> and <b>prim</b> of
+         * <b>hit</b> are set.
+         *
+         * @return <b>true</b> if something was hit
+         */
+        bool closest(const Ray3 &ray, double tMax, Hit &hit) const {
+            return grid.built() ? grid.intersect(store, ray, tMax, hit) : store.intersect(ray, tMax, hit);
+        }
+
+        /**
+         * Finds the closest intersection along a ray, with position and normal filled in.
+         *
+         * @return <b>true</b> if something was hit
+         */
+        bool intersect(const Ray3 &ray, double tMax, Hit &hit) const {
+            if (!closest(ray, tMax, hit))
+                return false;
+            store.finishHit(ray, hit);
+            return true;
+        }
+
+        /**
+         * Like <code>intersect</code>, but only tests the primitives in <b>candidates</b>.
+         */
+        bool intersect(const PrimitiveList &candidates, const Ray3 &ray, double tMax, Hit &hit) const {
+            if (!store.intersect(candidates, ray, tMax, hit))
+                return false;
+            store.finishHit(ray, hit);
+            return true;
+        }
+    };
+}
+#endif //RAYTRACER_C_PREPARED_SCENE_H
@@ -0,0 +1,214 @@
+/**
+* PrimitiveStore implementation
+*/
+
+#include "primitive_store.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace std;
+
+namespace bla {
+    namespace {
+        /**Hits closer than this are the surface the ray started on.*/
+        const double eps = 1e-6;
+
+        /**
+         * @return the nearest positive intersection distance of <b>ray</b> with <b>s</b>, or -1.0
+         */
+        inline double intersectSphere(const PackedSphere &s, const Ray3 &ray) {
+            // Same equation as Sphere::intersects, for unit length directions.
+            double px = ray.o.x - s.cx, py = ray.o.y - s.cy, pz = ray.o.z - s.cz;
+            double b = ray.d.x * px + ray.d.y * py + ray.d.z * pz;
+            double c = px * px + py * py + pz * pz - (double) s.r * s.r;
+            double discrim = b * b - c;
+            if (discrim < 0.0)
+                return -1.0;
+
+            double sq = sqrt(discrim);
+            double t = -b - sq;
+            if (t > eps)
+                return t;
+            t = -b + sq;
+            return t > eps ? t : -1.0;
+        }
+    }
+
+    PrimitiveStore::PrimitiveStore(const Scene &scene) {
+        TraceSpan span("primitive store", "build");
+        spheres.reserve(scene.size());
+        for (const Sphere &s : scene.spheres)
+            spheres.push_back(PackedSphere{(float) s.c.x, (float) s.c.y, (float) s.c.z, (float) s.r});
+
+        if (!spheres.empty())
+            batches.push_back(PrimitiveBatch{PrimitiveType::Sphere, 0, (uint32_t) spheres.size(), 0});
+        rehash();
+    }
+
+    void PrimitiveStore::rehash() {
+        // FNV-1a over 32 bit words; the records hold nothing but floats.
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for (const PackedSphere &s : spheres) {
+            const float words[4] = {s.cx, s.cy, s.cz, s.r};
+            for (float f : words) {
+                uint32_t w;
+                memcpy(&w, &f, sizeof(w));
+                h ^= w;
+                h *= 0x100000001b3ULL;
+            }
+        }
+        geometryHash = h;
+    }
+
+    bool PrimitiveStore::intersectSpheres(const PrimitiveBatch &batch, const Ray3 &ray, Hit &hit) const {
+        const PackedSphere *s = spheres.data() + batch.offset;
+        int best = -1;
+        for (uint32_t i = 0; i < batch.count; i++) {
+            double t = intersectSphere(s[i], ray);
+            if (t > 0.0 && t < hit.t) {
+                hit.t = t;
+                best = (int) i;
+            }
+        }
+        if (best < 0)
+            return false;
+        hit.prim = (int) batch.first + best;
+        return true;
+    }
+
+    bool PrimitiveStore::intersectSpheres(const PrimitiveBatch &batch, const uint32_t *ids, size_t count,
+                                          const Ray3 &ray, Hit &hit) const {
+        int best = -1;
+        for (size_t i = 0; i < count; i++) {
+            double t = intersectSphere(spheres[batch.offset + ids[i] - batch.first], ray);
+            if (t > 0.0 && t < hit.t) {
+                hit.t = t;
+                best = (int) ids[i];
+            }
+        }
+        if (best < 0)
+            return false;
+        hit.prim = best;
+        return true;
+    }
+
+    bool PrimitiveStore::intersect(const Ray3 &ray, double tMax, Hit &hit) const {
+        hit.t = tMax;
+        hit.prim = -1;
+        bool found = false;
+
+        for (const PrimitiveBatch &batch : batches) {
+            switch (batch.type) {
+                case PrimitiveType::Sphere:
+                    found |= intersectSpheres(batch, ray, hit);
+                    break;
+            }
+        }
+        return found;
+    }
+
+    bool PrimitiveStore::intersect(const PrimitiveList &candidates, const Ray3 &ray, double tMax, Hit &hit) const {
+        hit.t = tMax;
+        hit.prim = -1;
+        bool found = false;
+
+        // The ids are sorted, so the candidates of each batch form one run.
+        const uint32_t *ids = candidates.ids, *end = candidates.ids + candidates.count;
+        for (const PrimitiveBatch &batch : batches) {
+            if (ids == end)
+                break;
+            const uint32_t *run = ids;
+            while (run != end && *run < batch.first + batch.count)
+                run++;
+            if (run == ids)
+                continue;
+
+            switch (batch.type) {
+                case PrimitiveType::Sphere:
+                    found |= intersectSpheres(batch, ids, (size_t) (run - ids), ray, hit);
+                    break;
+            }
+            ids = run;
+        }
+        return found;
+    }
+
+    const PrimitiveBatch &PrimitiveStore::batchOf(uint32_t prim) const {
+        size_t b = 0;
+        while (prim >= batches[b].first + batches[b].count)
+            b++;
+        return batches[b];
+    }
+
+    double PrimitiveStore::intersectOne(uint32_t prim, const Ray3 &ray) const {
+        const PrimitiveBatch &batch = batchOf(prim);
+        switch (batch.type) {
+            case PrimitiveType::Sphere:
+                return intersectSphere(spheres[batch.offset + prim - batch.first], ray);
+        }
+        return -1.0;
+    }
+
+    void PrimitiveStore::finishHit(const Ray3 &ray, Hit &hit) const {
+        const PrimitiveBatch &batch = batchOf((uint32_t) hit.prim);
+        hit.p = ray.getPoint(hit.t);
+        switch (batch.type) {
+            case PrimitiveType::Sphere: {
+                const PackedSphere &s = spheres[batch.offset + hit.prim - batch.first];
+                hit.n = Vector3(hit.p.x - s.cx, hit.p.y - s.cy, hit.p.z - s.cz);
+                hit.n.norm();
+                break;
+            }
+        }
+    }
+
+    void PrimitiveStore::boundingSphere(uint32_t prim, Vector3 &c, double &r) const {
+        const PrimitiveBatch &batch = batchOf(prim);
+        switch (batch.type) {
+            case PrimitiveType::Sphere: {
+                const PackedSphere &s = spheres[batch.offset + prim - batch.first];
+                c = Vector3(s.cx, s.cy, s.cz);
+                r = s.r;
+                break;
+            }
+        }
+    }
+
+    void PrimitiveStore::translate(const Vector3 &d) {
+        for (const PrimitiveBatch &batch : batches) {
+            switch (batch.type) {
+                case PrimitiveType::Sphere:
+                    for (uint32_t i = 0; i < batch.count; i++) {
+                        PackedSphere &s = spheres[batch.offset + i];
+                        s.cx = (float) (s.cx + d.x);
+                        s.cy = (float) (s.cy + d.y);
+                        s.cz = (float) (s.cz + d.z);
+                    }
+                    break;
+            }
+        }
+        rehash();
+    }
+
+    void PrimitiveStore::transform(const Matrix4 &M) {
+        array<double, 16> m = M.getMatrix();
+        double scale = sqrt(max(m[0] * m[0] + m[1] * m[1] + m[2] * m[2],
+                                max(m[4] * m[4] + m[5] * m[5] + m[6] * m[6],
+                                    m[8] * m[8] + m[9] * m[9] + m[10] * m[10])));
+
+        for (const PrimitiveBatch &batch : batches) {
+            switch (batch.type) {
+                case PrimitiveType::Sphere:
+                    for (uint32_t i = 0; i < batch.count; i++) {
+                        PackedSphere &s = spheres[batch.offset + i];
+                        Vector3 c = M.getTransformedVec(Vector3(s.cx, s.cy, s.cz));
+                        s = PackedSphere{(float) c.x, (float) c.y, (float) c.z, (float) (s.r * scale)};
+                    }
+                    break;
+            }
+        }
+        rehash();
+    }
+}
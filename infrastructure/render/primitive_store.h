@@ -0,0 +1,172 @@
+#ifndef RAYTRACER_C_PRIMITIVE_STORE_H
+#define RAYTRACER_C_PRIMITIVE_STORE_H
+
+#include "../math/mat4.h"
+#include "../math/ray.h"
+#include "scene.h"
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+namespace bla {
+    /**
+     * The kinds of primitive a <code>PrimitiveStore</code> can hold.
+     */
+    enum class PrimitiveType : uint8_t {
+        Sphere
+    };
+
+    /**
+     * A sphere as the tracer stores it: center and radius in single precision, 16 bytes,
+     * no vtable. Intersection math is still done in double precision.
+     */
+    struct PackedSphere {
+        float cx, cy, cz, r;
+    };
+
+    static_assert(sizeof(PackedSphere) == 16, "PackedSphere must stay 16 bytes");
+
+    /**
+     * A run of primitives of the same type. Batch <i>b</i> covers primitive ids
+     * <code>[b.first, b.first + b.count)</code>, which are also the indices into the
+     * store's array for <code>b.type</code> minus <code>b.offset</code>.
+     */
+    struct PrimitiveBatch {
+        PrimitiveType type;
+        /**First primitive id (index into the <code>Scene</code>) of the batch*/
+        uint32_t first;
+        uint32_t count;
+        /**Index of the batch's first element in the array for its type*/
+        uint32_t offset;
+    };
+
+    /**
+     * A list of primitive ids in ascending order, e.g. the candidates of a screen tile.
+     */
+    struct PrimitiveList {
+        const uint32_t *ids;
+        size_t count;
+    };
+
+    /**
+     * Compact, devirtualized storage for the primitives the tracer intersects. Primitives
+     * live in one contiguous array per type, and the code that touches them switches on
+     * the type once per batch rather than making a virtual call per primitive.
+     * <p>
+     * Primitive ids match the indices of the <code>Scene</code> the store was built from,
+     * so materials and lights are looked up the same way as before.
+     * </p>
+     * <p>
+     * Centers and radii are rounded to single precision, so surfaces sit up to that rounding
+     * away from the <code>Sphere</code> they were packed from, and an image differs from one
+     * traced against the spheres by about as much. The renderer never mixes the two: camera,
+     * bounce and shadow rays, light sampling and the light hierarchy all use the store.
+     * </p>
+     */
+    class PrimitiveStore {
+    private:
+        vector<PrimitiveBatch> batches;
+        vector<PackedSphere> spheres;
+        uint64_t geometryHash = 0;
+
+        /**
+         * Recomputes <b>geometryHash</b> after the primitives changed.
+         */
+        void rehash();
+
+        bool intersectSpheres(const PrimitiveBatch &batch, const Ray3 &ray, Hit &hit) const;
+
+        bool intersectSpheres(const PrimitiveBatch &batch, const uint32_t *ids, size_t count, const Ray3 &ray,
+                              Hit &hit) const;
+
+        const PrimitiveBatch &batchOf(uint32_t prim) const;
+
+    public:
+        PrimitiveStore() {}
+
+        /**
+         * Packs the primitives of a scene.
+         */
+        explicit PrimitiveStore(const Scene &scene);
+
+        size_t size() const {
+            return spheres.size();
+        }
+
+        const vector<PrimitiveBatch> &getBatches() const {
+            return batches;
+        }
+
+        const vector<PackedSphere> &getSpheres() const {
+            return spheres;
+        }
+
+        /**
+         * @return a hash of the packed primitives. It changes exactly when the geometry rays
+         * are traced against does, whatever the change was made through, so caches of
+         * visibility can key on it
+         */
+        uint64_t getGeometryHash() const {
+            return geometryHash;
+        }
+
+        /**
+         * @return bytes used by the primitive data
+         */
+        size_t memoryUsage() const {
+            return spheres.size() * sizeof(PackedSphere) + batches.size() * sizeof(PrimitiveBatch);
+        }
+
+        /**
+         * Finds the closest intersection along a ray. Only <b>t</b> and <b>prim</b> of
+         * <b>hit</b> are set; call <code>finishHit</code> for the rest.
+         *
+         * @param ray the ray to trace
+         * @param tMax ignore intersections farther than this
+         * @param hit receives the closest intersection
+         * @return <b>true</b> if something was hit
+         */
+        bool intersect(const Ray3 &ray, double tMax, Hit &hit) const;
+
+        /**
+         * Like <code>intersect</code>, but only tests the primitives in <b>candidates</b>.
+         * The result is the same as tracing the whole store as long as the candidates
+         * include every primitive the ray can hit.
+         */
+        bool intersect(const PrimitiveList &candidates, const Ray3 &ray, double tMax, Hit &hit) const;
+
+        /**
+         * Computes a sphere that bounds a primitive.
+         *
+         * @param prim the primitive
+         * @param c receives the center
+         * @param r receives the radius
+         */
+        void boundingSphere(uint32_t prim, Vector3 &c, double &r) const;
+
+        /**
+         * Tests a ray against a single primitive.
+         *
+         * @return the nearest positive intersection distance, or -1.0
+         */
+        double intersectOne(uint32_t prim, const Ray3 &ray) const;
+
+        /**
+         * Fills in the position and normal of a hit whose <b>t</b> and <b>prim</b> are set,
+         * using the same (packed) geometry the intersection was found with.
+         */
+        void finishHit(const Ray3 &ray, Hit &hit) const;
+
+        /**
+         * Moves every primitive by <b>d</b>.
+         */
+        void translate(const Vector3 &d);
+
+        /**
+         * Applies a transform to every primitive. Sphere centers are transformed as points
+         * and radii are scaled by the largest axis scale of <b>M</b>.
+         */
+        void transform(const Matrix4 &M);
+    };
+}
+#endif //RAYTRACER_C_PRIMITIVE_STORE_H
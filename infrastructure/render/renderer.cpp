@@ -0,0 +1,287 @@
+/**
+* Renderer implementation
+*/
+
+#include "renderer.h"
+#include "color.h"
+#include "trace.h"
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+namespace bla {
+    namespace {
+        /**
+         * Builds two unit vectors perpendicular to the unit vector <b>n</b> and each other
+         * (Duff et al. 2017).
+         */
+        void orthonormalBasis(const Vector3 &n, Vector3 &t, Vector3 &b) {
+            double sign = n.z >= 0.0 ? 1.0 : -1.0;
+            double a = -1.0 / (sign + n.z);
+            double c = n.x * n.y * a;
+            t = Vector3(1.0 + sign * n.x * n.x * a, sign * c, -sign * n.x);
+            b = Vector3(c, sign + n.y * n.y * a, -n.y);
+        }
+
+        /**
+         * Picks a cosine weighted direction on the hemisphere around <b>n</b>.
+         */
+        Vector3 sampleCosineHemisphere(const Vector3 &n, Sampler &sampler) {
+            double r1 = sampler.next1D();
+            double r2 = sampler.next1D();
+            double phi = 2.0 * M_PI * r1;
+            double r = sqrt(r2);
+
+            Vector3 t, b;
+            orthonormalBasis(n, t, b);
+            return t * (r * cos(phi)) + b * (r * sin(phi)) + n * sqrt(max(0.0, 1.0 - r2));
+        }
+    }
+
+    Vector3 Renderer::sampleDirect(const PreparedScene &ps, const Hit &hit, const Vector3 &n, Sampler &sampler,
+                                   uint64_t &rays) {
+        LightChoice light = ps.lights.sample(hit.p, n, sampler.next1D());
+        double u1 = sampler.next1D(), u2 = sampler.next1D();
+        if (light.prim < 0 || light.prim == hit.prim)
+            return VEC_ZERO;
+
+        // Sample a direction uniformly inside the cone the light sphere covers as seen from the hit,
+        // using the same packed sphere the shadow ray is traced against.
+        Vector3 c;
+        double r;
+        ps.store.boundingSphere((uint32_t) light.prim, c, r);
+        Vector3 w = c - hit.p;
+        double dist2 = w.sqr();
+        double sin2 = r * r / dist2;
+        if (sin2 >= 1.0)
+            return VEC_ZERO;
+        w *= 1.0 / sqrt(dist2);
+
+        // 1 - cos(theta max), written so it stays accurate for small, distant lights.
+        double cosMax = sqrt(1.0 - sin2);
+        double oneMinusCos = sin2 / (1.0 + cosMax);
+        double cosT = 1.0 - u1 * oneMinusCos;
+        double sinT = sqrt(max(0.0, 1.0 - cosT * cosT));
+        double phi = 2.0 * M_PI * u2;
+
+        Vector3 t, b;
+        orthonormalBasis(w, t, b);
+        Vector3 dir = t * (sinT * cos(phi)) + b * (sinT * sin(phi)) + w * cosT;
+        double cosSurface = dir * n;
+        if (cosSurface <= 0.0)
+            return VEC_ZERO;
+
+        Hit shadow;
+        rays++;
+        if (!ps.closest(Ray3(hit.p, dir), numeric_limits<double>::infinity(), shadow) ||
+            shadow.prim != light.prim)
+            return VEC_ZERO;
+
+        double pdf = light.pmf / (2.0 * M_PI * oneMinusCos);
+        // Lambertian BRDF is albedo / pi; the caller multiplies by the albedo.
+        return ps.scene.materials[light.prim].emission * (cosSurface / (M_PI * pdf));
+    }
+
+    Vector3 Renderer::trace(const PreparedScene &ps, Ray3 ray, Sampler &sampler, int maxDepth, Hit *first,
+                            uint64_t &rays, const PrimitiveList *primary) {
+        Hit hit;
+        rays++;
+        bool found = primary != nullptr
+                     ? ps.intersect(*primary, ray, numeric_limits<double>::infinity(), hit)
+                     : ps.intersect(ray, numeric_limits<double>::infinity(), hit);
+        if (!found)
+            hit.prim = -1;
+        if (first != nullptr)
+            *first = hit;
+
+        return shade(ps, ray, hit, sampler, maxDepth, rays);
+    }
+
+    Vector3 Renderer::shade(const PreparedScene &ps, Ray3 ray, Hit hit, Sampler &sampler, int maxDepth,
+                            uint64_t &rays) {
+        const Scene &scene = ps.scene;
+        Vector3 radiance = VEC_ZERO;
+        Vector3 throughput(1.0, 1.0, 1.0);
+
+        for (int depth = 0;; depth++) {
+            if (hit.prim < 0) {
+                radiance += mulColor(throughput, scene.background);
+                break;
+            }
+
+            const Material &m = scene.materials[hit.prim];
+            // Emitters seen after a bounce were already accounted for by next event estimation.
+            if (depth == 0)
+                radiance += mulColor(throughput, m.emission);
+
+            Vector3 n = hit.n;
+            if (n * ray.d > 0.0)
+                n *= -1.0;
+
+            throughput = mulColor(throughput, m.albedo);
+            if (!ps.lights.empty())
+                radiance += mulColor(throughput, sampleDirect(ps, hit, n, sampler, rays));
+
+            // Russian roulette once the path has bounced a few times.
+            if (depth >= 3) {
+                double q = max(throughput.x, max(throughput.y, throughput.z));
+                if (q < 1.0) {
+                    if (sampler.next1D() >= q)
+                        break;
+                    throughput *= 1.0 / q;
+                }
+            }
+            if (depth == maxDepth)
+                break;
+
+            ray = Ray3(hit.p, sampleCosineHemisphere(n, sampler));
+            rays++;
+            if (!ps.intersect(ray, numeric_limits<double>::infinity(), hit))
+                hit.prim = -1;
+        }
+
+        return radiance;
+    }
+
+    uint64_t Renderer::accumulatePixel(const PreparedScene &ps, const Camera &camera, const RenderSettings &settings,
+                                       int x, int y, int first, int last, PixelSums &sums,
+                                       const PrimitiveList *candidates, GBufferCache *gbuffer, bool replay) {
+        const Scene &scene = ps.scene;
+        size_t i = (size_t) y * settings.width + x;
+        uint64_t rays = 0;
+
+        for (int s = first; s < last; s++) {
+            Sampler sampler(settings.seed, i, (uint64_t) s);
+            double sx = (x + sampler.next1D()) / settings.width;
+            double sy = (y + sampler.next1D()) / settings.height;
+            Ray3 ray = camera.generateRay(sx, sy);
+
+            Hit hit;
+            if (replay) {
+                const PrimaryHit &cached = gbuffer->at(i, s);
+                hit.t = cached.t;
+                hit.prim = cached.prim;
+                if (hit.prim >= 0)
+                    ps.store.finishHit(ray, hit);
+            } else {
+                rays++;
+                bool found = candidates != nullptr
+                             ? ps.intersect(*candidates, ray, numeric_limits<double>::infinity(), hit)
+                             : ps.intersect(ray, numeric_limits<double>::infinity(), hit);
+                if (!found)
+                    hit.prim = -1;
+                if (gbuffer != nullptr)
+                    gbuffer->at(i, s) = PrimaryHit{hit.t, hit.prim};
+            }
+
+            Vector3 c = shade(ps, ray, hit, sampler, settings.maxDepth, rays);
+            double l = luminance(c);
+            sums.color += c;
+            sums.lum += l;
+            sums.lum2 += l * l;
+            if (hit.prim >= 0) {
+                sums.albedo += scene.materials[hit.prim].albedo;
+                sums.emission += scene.materials[hit.prim].emission;
+                sums.normal += hit.n;
+                sums.depth += hit.t;
+            } else {
+                sums.albedo += Vector3(1.0, 1.0, 1.0);
+            }
+        }
+        return rays;
+    }
+
+    uint64_t Renderer::renderTile(const PreparedScene &ps, const Camera &camera, const RenderSettings &settings,
+                                  const Tile &tile, FrameBuffer &out, const TileBins *bins, GBufferCache *gbuffer) {
+        TraceSpan span("tile", "render", tile.index);
+        uint64_t rays = 0;
+        PrimitiveList candidates = bins != nullptr ? bins->candidates(tile.index) : PrimitiveList{nullptr, 0};
+        bool replay = gbuffer != nullptr && gbuffer->matches(gbufferKey(ps, camera, settings));
+
+        for (int y = tile.y0; y < tile.y1; y++) {
+            for (int x = tile.x0; x < tile.x1; x++) {
+                PixelSums sums;
+                rays += accumulatePixel(ps, camera, settings, x, y, 0, settings.spp, sums,
+                                        bins != nullptr ? &candidates : nullptr, gbuffer, replay);
+                out.resolve(out.index(x, y), sums, settings.spp);
+            }
+        }
+        return rays;
+    }
+
+    GBufferKey Renderer::gbufferKey(const PreparedScene &scene, const Camera &camera, const RenderSettings &settings) {
+        GBufferKey key;
+        key.camera = camera;
+        key.width = settings.width;
+        key.height = settings.height;
+        key.spp = settings.spp;
+        key.seed = settings.seed;
+        key.region = settings.renderRegion();
+        key.primitives = scene.store.size();
+        key.geometry = scene.store.getGeometryHash();
+        return key;
+    }
+
+    RenderStats Renderer::render(const Scene &scene, const Camera &camera, const RenderSettings &settings,
+                                 FrameBuffer &out, const TileCallback &onTile) {
+        return render(PreparedScene(scene, settings.accelerator, settings.threads), camera, settings, out, onTile);
+    }
+
+    RenderStats Renderer::render(const PreparedScene &scene, const Camera &camera, const RenderSettings &settings,
+                                 FrameBuffer &out, const TileCallback &onTile) {
+        return render(scene, camera, settings, out, nullptr, onTile);
+    }
+
+    RenderStats Renderer::render(const PreparedScene &scene, const Camera &camera, const RenderSettings &settings,
+                                 FrameBuffer &out, GBufferCache &gbuffer, const TileCallback &onTile) {
+        return render(scene, camera, settings, out, &gbuffer, onTile);
+    }
+
+    RenderStats Renderer::render(const PreparedScene &scene, const Camera &camera, const RenderSettings &settings,
+                                 FrameBuffer &out, GBufferCache *gbuffer, const TileCallback &onTile) {
+        TraceSpan span("render", "render");
+        auto start = chrono::steady_clock::now();
+        out.resize(settings.width, settings.height);
+        vector<Tile> tiles = makeTiles(settings.renderRegion(), settings.tileSize);
+
+        RenderStats stats;
+        if (gbuffer != nullptr) {
+            GBufferKey key = gbufferKey(scene, camera, settings);
+            stats.reusedPrimary = gbuffer->matches(key);
+            if (!stats.reusedPrimary)
+                gbuffer->reset(key);
+        }
+
+        // Replayed hits need no primary rays, so there is nothing to bin.
+        TileBins bins;
+        bool binned = settings.binPrimary && !stats.reusedPrimary && !scene.grid.built();
+        if (binned)
+            bins = TileBins(scene.store, camera, settings.width, settings.height, settings.renderRegion(),
+                            settings.tileSize);
+
+        // One counter per worker, so the threads never write to the same counter.
+        int threads = resolveThreads(settings.threads);
+        vector<uint64_t> rays((size_t) threads, 0);
+        atomic<bool> skipped(false);
+        parallelFor(tiles.size(), threads, [&](size_t t, int worker) {
+            if (settings.stop != nullptr && *settings.stop) {
+                skipped = true;
+                return;
+            }
+            rays[worker] += renderTile(scene, camera, settings, tiles[t], out, binned ? &bins : nullptr, gbuffer);
+            if (onTile)
+                onTile(tiles[t]);
+        });
+        // A stopped render left tiles of the cache unfilled, so it stays invalid.
+        stats.stopped = skipped;
+        if (gbuffer != nullptr && !stats.stopped)
+            gbuffer->validate();
+
+        for (uint64_t r : rays)
+            stats.rays += r;
+        stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        return stats;
+    }
+}
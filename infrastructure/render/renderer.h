@@ -0,0 +1,212 @@
+#ifndef RAYTRACER_C_RENDERER_H
+#define RAYTRACER_C_RENDERER_H
+
+#include "camera.h"
+#include "framebuffer.h"
+#include "gbuffer.h"
+#include "prepared_scene.h"
+#include "sampler.h"
+#include "scene.h"
+#include "tile_bins.h"
+#include "tiles.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+using namespace std;
+namespace bla {
+    /**
+     * Options for a single render.
+     */
+    struct RenderSettings {
+        /**
+         * Largest <b>maxDepth</b> callers accept. Russian roulette never ends a path off a
+         * white surface, so the depth is what bounds the work per sample.
+         */
+        static const int MAX_DEPTH = 64;
+
+        int width = 320;
+        int height = 240;
+        /**Samples per pixel*/
+        int spp = 16;
+        /**Maximum number of bounces along a path*/
+        int maxDepth = 4;
+        /**Edge length of the square tiles the image is split into*/
+        int tileSize = 16;
+        /**Number of worker threads, or 0 for one per hardware thread*/
+        int threads = 0;
+        /**Seed for the per-pixel samplers*/
+        uint64_t seed = 1;
+        /**
+         * Trace primary rays against per-tile candidate lists (see <code>TileBins</code>).
+         * Scenes with a <code>UniformGrid</code> trace primary rays through the grid instead.
+         */
+        bool binPrimary = true;
+        /**How <code>render(const Scene &, ...)</code> prepares the scene*/
+        Accelerator accelerator = Accelerator::Auto;
+        /**The part of the image to render; an empty region means the whole image*/
+        Tile region = {0, 0, 0, 0, 0};
+        /**
+         * If not <code>nullptr</code>, no more tiles are started once this becomes <b>true</b>,
+         * e.g. because the client waiting for the image went away
+         */
+        const atomic<bool> *stop = nullptr;
+
+        /**
+         * @return <b>region</b> clamped to the image, or the whole image if it is empty
+         */
+        Tile renderRegion() const {
+            Tile r = {max(region.x0, 0), max(region.y0, 0), min(region.x1, width), min(region.y1, height), 0};
+            if (r.x1 <= r.x0 || r.y1 <= r.y0)
+                r = {0, 0, width, height, 0};
+            return r;
+        }
+    };
+
+    /**
+     * What a render did, for throughput measurements.
+     */
+    struct RenderStats {
+        /**Rays traced: camera, bounce and shadow rays*/
+        uint64_t rays = 0;
+        /**Wall clock time of the render*/
+        double seconds = 0.0;
+        /**Whether the first hits came from a <code>GBufferCache</code> instead of being traced*/
+        bool reusedPrimary = false;
+        /**Whether <code>RenderSettings::stop</code> cut the render short*/
+        bool stopped = false;
+
+        double raysPerSecond() const {
+            return seconds > 0.0 ? rays / seconds : 0.0;
+        }
+    };
+
+    /**
+     * Called from a worker thread whenever a tile of the image is finished.
+     */
+    typedef function<void(const Tile &)> TileCallback;
+
+    /**
+     * A tiled, multithreaded path tracer for diffuse scenes. Direct light from emissive
+     * primitives is gathered at every bounce with next event estimation, picking one light
+     * per bounce from the scene's <code>LightBVH</code>. Next to the color it writes the
+     * first-hit albedo, normal and depth into the <code>FrameBuffer</code>.
+     */
+    class Renderer {
+    private:
+        static RenderStats render(const PreparedScene &scene, const Camera &camera, const RenderSettings &settings,
+                                  FrameBuffer &out, GBufferCache *gbuffer, const TileCallback &onTile);
+
+    public:
+        /**
+         * Renders an image, or the region of it selected in <b>settings</b>.
+         *
+         * @param scene the scene to render
+         * @param camera the camera to render from; its aspect ratio is taken as is
+         * @param settings the render options
+         * @param out receives the image and AOVs; resized to the requested resolution. Pixels
+         *            outside the region of <b>settings</b> are left black
+         * @param onTile if set, called as soon as each tile is done. Calls may come from several
+         *            threads at once
+         * @return the number of rays traced and the time it took
+         */
+        static RenderStats render(const PreparedScene &scene, const Camera &camera, const RenderSettings &settings,
+                                  FrameBuffer &out, const TileCallback &onTile = nullptr);
+
+        /**
+         * Renders an image, reusing the first hits stored in <b>gbuffer</b> if they are still
+         * valid for this scene, camera and resolution, and storing them there otherwise. A
+         * render that only changes materials or lights then only traces secondary rays.
+         * <p>
+         * The result is exactly what the other overloads produce.
+         * </p>
+         */
+        static RenderStats render(const PreparedScene &scene, const Camera &camera, const RenderSettings &settings,
+                                  FrameBuffer &out, GBufferCache &gbuffer, const TileCallback &onTile = nullptr);
+
+        /**
+         * Prepares <b>scene</b> and renders it. Prefer the <code>PreparedScene</code> overload
+         * when rendering the same scene more than once.
+         */
+        static RenderStats render(const Scene &scene, const Camera &camera, const RenderSettings &settings,
+                                  FrameBuffer &out, const TileCallback &onTile = nullptr);
+
+        /**
+         * Renders one tile of an image. <b>out</b> must already have the full image size.
+         *
+         * @param bins if not <code>nullptr</code>, primary rays are only tested against the
+         *             tile's candidates
+         * @param gbuffer if not <code>nullptr</code>, first hits are replayed from it if it matches
+         *                the render, and stored into it otherwise; in that case it must have been
+         *                reset with this render's key
+         * @return the number of rays traced
+         */
+        static uint64_t renderTile(const PreparedScene &scene, const Camera &camera, const RenderSettings &settings,
+                                   const Tile &tile, FrameBuffer &out, const TileBins *bins = nullptr,
+                                   GBufferCache *gbuffer = nullptr);
+
+        /**
+         * Adds samples <code>[first, last)</code> of pixel (<b>x</b>, <b>y</b>) to <b>sums</b>.
+         * Samples are independent of each other and always added in order, so accumulating a
+         * pixel in several calls gives exactly the same sums as accumulating it in one.
+         *
+         * @param candidates if not <code>nullptr</code>, the only primitives primary rays can hit
+         * @param gbuffer if not <code>nullptr</code>, first hits are replayed from it if
+         *                <b>replay</b> is set, and stored into it otherwise
+         * @return the number of rays traced
+         */
+        static uint64_t accumulatePixel(const PreparedScene &scene, const Camera &camera, const RenderSettings &settings,
+                                        int x, int y, int first, int last, PixelSums &sums,
+                                        const PrimitiveList *candidates = nullptr, GBufferCache *gbuffer = nullptr,
+                                        bool replay = false);
+
+        /**
+         * @return the key under which a <code>GBufferCache</code> stores the first hits of a render
+         */
+        static GBufferKey gbufferKey(const PreparedScene &scene, const Camera &camera, const RenderSettings &settings);
+
+        /**
+         * Follows one path through the scene.
+         *
+         * @param scene the scene to trace
+         * @param ray the primary ray
+         * @param sampler the random numbers for this path
+         * @param maxDepth the maximum number of bounces
+         * @param first if not <code>nullptr</code>, receives the first hit (prim is -1 on a miss)
+         * @param rays incremented for every ray traced
+         * @param primary if not <code>nullptr</code>, the only primitives <b>ray</b> can hit
+         * @return the radiance carried back along <b>ray</b>
+         */
+        static Vector3 trace(const PreparedScene &scene, Ray3 ray, Sampler &sampler, int maxDepth, Hit *first,
+                             uint64_t &rays, const PrimitiveList *primary = nullptr);
+
+        /**
+         * Follows a path whose first hit is already known.
+         *
+         * @param scene the scene to trace
+         * @param ray the primary ray
+         * @param hit the first hit of <b>ray</b>, with prim -1 on a miss
+         * @param sampler the random numbers for this path
+         * @param maxDepth the maximum number of bounces
+         * @param rays incremented for every ray traced
+         * @return the radiance carried back along <b>ray</b>
+         */
+        static Vector3 shade(const PreparedScene &scene, Ray3 ray, Hit hit, Sampler &sampler, int maxDepth,
+                             uint64_t &rays);
+
+        /**
+         * Estimates the light arriving at a diffuse surface directly from the emitters, using
+         * one light picked from the light hierarchy and one point sampled on it.
+         *
+         * @param scene the scene
+         * @param hit the shading point
+         * @param n the normal at the shading point, facing the side the light arrives from
+         * @param sampler the random numbers for this path
+         * @param rays incremented for every ray traced
+         * @return the reflected radiance, before multiplying by the albedo
+         */
+        static Vector3 sampleDirect(const PreparedScene &scene, const Hit &hit, const Vector3 &n, Sampler &sampler,
+                                    uint64_t &rays);
+    };
+}
+#endif //RAYTRACER_C_RENDERER_H
@@ -0,0 +1,53 @@
+#ifndef RAYTRACER_C_SAMPLER_H
+#define RAYTRACER_C_SAMPLER_H
+
+#include <cstdint>
+
+using namespace std;
+namespace bla {
+    /**
+     * A small deterministic random number generator. Every sample of every pixel gets its
+     * own stream, seeded from <code>(seed, pixel, sample)</code>, so an image comes out the
+     * same no matter how the work is split between threads or passes.
+     */
+    class Sampler {
+    private:
+        uint64_t state;
+
+        static uint64_t mix(uint64_t z) {
+            // splitmix64 finalizer
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            return z ^ (z >> 31);
+        }
+
+    public:
+        /**
+         * Creates the sampler for one pixel sample.
+         *
+         * @param seed the seed of the whole image
+         * @param pixel the index of the pixel (<code>y * width + x</code>)
+         * @param sample the index of the sample within the pixel
+         */
+        Sampler(uint64_t seed, uint64_t pixel, uint64_t sample) {
+            state = mix(mix(seed ^ 0x9e3779b97f4a7c15ULL) + pixel);
+            state = mix(state + sample * 0x9e3779b97f4a7c15ULL);
+        }
+
+        /**
+         * @return the next 64 random bits
+         */
+        uint64_t nextBits() {
+            state += 0x9e3779b97f4a7c15ULL;
+            return mix(state);
+        }
+
+        /**
+         * @return a uniformly distributed number in <code>[0, 1)</code>
+         */
+        double next1D() {
+            return (nextBits() >> 11) * (1.0 / 9007199254740992.0);
+        }
+    };
+}
+#endif //RAYTRACER_C_SAMPLER_H
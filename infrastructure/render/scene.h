@@ -0,0 +1,120 @@
+#ifndef RAYTRACER_C_SCENE_H
+#define RAYTRACER_C_SCENE_H
+
+#include "../math/vec3.h"
+#include "../math/ray.h"
+#include "../math/sphere.h"
+#include <vector>
+#include <limits>
+
+using namespace std;
+namespace bla {
+    /**
+     * The surface description of a primitive. Every surface is diffuse; a non-zero
+     * <b>emission</b> turns the primitive into a light.
+     */
+    struct Material {
+        /**Diffuse reflectance, each channel in <code>[0, 1]</code>*/
+        Vector3 albedo;
+        /**Emitted radiance*/
+        Vector3 emission;
+
+        Material(Vector3 albedo = Vector3(0.8, 0.8, 0.8), Vector3 emission = VEC_ZERO)
+                : albedo(albedo), emission(emission) {}
+
+        bool isEmissive() const {
+            return emission.x > 0.0 || emission.y > 0.0 || emission.z > 0.0;
+        }
+    };
+
+    /**
+     * The closest intersection found along a ray.
+     */
+    struct Hit {
+        /**Distance along the ray*/
+        double t = numeric_limits<double>::infinity();
+        /**Index of the primitive that was hit, or -1*/
+        int prim = -1;
+        /**World space position of the hit*/
+        Vector3 p;
+        /**Unit surface normal at the hit*/
+        Vector3 n;
+    };
+
+    /**
+     * A collection of spheres and their materials. <code>spheres[i]</code> uses
+     * <code>materials[i]</code>.
+     */
+    class Scene {
+    public:
+        vector<Sphere> spheres;
+        vector<Material> materials;
+        /**Radiance of rays that escape the scene*/
+        Vector3 background;
+
+        Scene() : background(VEC_ZERO) {}
+
+        /**
+         * Adds a sphere to the scene.
+         * @return the index of the new primitive
+         */
+        int add(const Sphere &s, const Material &m) {
+            spheres.push_back(s);
+            materials.push_back(m);
+            return (int) spheres.size() - 1;
+        }
+
+        size_t size() const {
+            return spheres.size();
+        }
+
+        /**
+         * Finds the closest intersection along a ray.
+         *
+         * @param ray the ray to trace
+         * @param tMax ignore intersections farther than this
+         * @param hit receives the closest intersection
+         * @return <b>true</b> if something was hit
+         */
+        bool intersect(const Ray3 &ray, double tMax, Hit &hit) const {
+            hit.t = tMax;
+            hit.prim = -1;
+            for (size_t i = 0; i < spheres.size(); i++) {
+                double t = closestT(spheres[i], ray);
+                if (t > 0.0 && t < hit.t) {
+                    hit.t = t;
+                    hit.prim = (int) i;
+                }
+            }
+            if (hit.prim < 0)
+                return false;
+
+            finishHit(ray, hit);
+            return true;
+        }
+
+        /**
+         * Fills in the position and normal of a hit whose <b>t</b> and <b>prim</b> are set.
+         */
+        void finishHit(const Ray3 &ray, Hit &hit) const {
+            const Sphere &s = spheres[hit.prim];
+            hit.p = ray.getPoint(hit.t);
+            hit.n = hit.p - s.c;
+            hit.n.norm();
+        }
+
+        /**
+         * @return the nearest positive intersection distance of <b>ray</b> with <b>s</b>, or -1.0
+         */
+        static double closestT(const Sphere &s, const Ray3 &ray) {
+            // Offset hits that are practically on the surface so rays leaving it do not hit it again.
+            static const double eps = 1e-6;
+            array<double, 2> t = s.intersects(ray);
+            double near = t[1], far = t[0];
+            if (near > eps)
+                return near;
+            return far > eps ? far : -1.0;
+        }
+    };
+}
+#endif //RAYTRACER_C_SCENE_H
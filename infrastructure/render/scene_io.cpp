@@ -0,0 +1,75 @@
+/**
+* Scene description parsing
+*/
+
+#include "scene_io.h"
+#include "trace.h"
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+namespace bla {
+    bool parseScene(const string &text, Scene &scene, string &error) {
+        TraceSpan span("parse scene", "scene");
+        istringstream in(text);
+        string line;
+        int lineNo = 0;
+        scene = Scene();
+
+        while (getline(in, line)) {
+            lineNo++;
+            size_t hash = line.find('#');
+            if (hash != string::npos)
+                line.erase(hash);
+
+            istringstream ls(line);
+            string kind;
+            if (!(ls >> kind))
+                continue;
+
+            if (kind == "background") {
+                Vector3 &b = scene.background;
+                if (!(ls >> b.x >> b.y >> b.z)) {
+                    error = "line " + to_string(lineNo) + ": expected 'background r g b'";
+                    return false;
+                }
+            } else if (kind == "sphere") {
+                Vector3 c, a, e;
+                double r;
+                if (!(ls >> c.x >> c.y >> c.z >> r >> a.x >> a.y >> a.z)) {
+                    error = "line " + to_string(lineNo) + ": expected 'sphere cx cy cz radius ar ag ab [er eg eb]'";
+                    return false;
+                }
+                if (!(ls >> e.x >> e.y >> e.z))
+                    e = VEC_ZERO;
+                scene.add(Sphere(c, r), Material(a, e));
+            } else {
+                error = "line " + to_string(lineNo) + ": unknown entry '" + kind + "'";
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool readTextFile(const string &path, string &text) {
+        TraceSpan span("read", "io");
+        ifstream in(path, ios::binary);
+        if (!in)
+            return false;
+        ostringstream ss;
+        ss << in.rdbuf();
+        text = ss.str();
+        return true;
+    }
+
+    uint64_t hashScene(const string &text) {
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for (unsigned char c : text) {
+            h ^= c;
+            h *= 0x100000001b3ULL;
+        }
+        return h;
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef RAYTRACER_C_SCENE_IO_H
+#define RAYTRACER_C_SCENE_IO_H
+
+#include "scene.h"
+#include <cstdint>
+#include <string>
+
+using namespace std;
+namespace bla {
+    /**
+     * Parses a scene description. The format is line based; blank lines and everything
+     * after a <code>#</code> are ignored:
+     *
+     * <pre>
+     * background r g b
+     * sphere cx cy cz radius ar ag ab [er eg eb]
+     * </pre>
+     *
+     * where <code>a*</code> is the albedo and the optional <code>e*</code> is the emitted radiance.
+     *
+     * @param text the scene description
+     * @param scene receives the parsed scene
+     * @param error receives a description of the first problem if parsing fails
+     * @return <b>true</b> on success
+     */
+    bool parseScene(const string &text, Scene &scene, string &error);
+
+    /**
+     * Reads a file into a string.
+     *
+     * @return <b>true</b> on success
+     */
+    bool readTextFile(const string &path, string &text);
+
+    /**
+     * Hashes a scene description (64 bit FNV-1a), used to recognize scenes that were already loaded.
+     */
+    uint64_t hashScene(const string &text);
+}
+#endif //RAYTRACER_C_SCENE_IO_H
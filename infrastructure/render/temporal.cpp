@@ -0,0 +1,222 @@
+/**
+* TemporalRenderer implementation
+*/
+
+#include "temporal.h"
+#include "color.h"
+#include "trace.h"
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+namespace bla {
+    vector<TemporalRenderer::PrimitiveState> TemporalRenderer::stateOf(const PreparedScene &scene) {
+        vector<PrimitiveState> state(scene.store.size());
+        for (uint32_t i = 0; i < state.size(); i++) {
+            scene.store.boundingSphere(i, state[i].c, state[i].r);
+            state[i].material = scene.scene.materials[i];
+        }
+        return state;
+    }
+
+    bool TemporalRenderer::affects(const Bounds &changed, const Vector3 &p, const vector<Bounds> &lights) const {
+        Vector3 toChanged = changed.c - p;
+        double dist2 = toChanged.sqr();
+        if (changed.r * changed.r >= temporal.bounceAngle * temporal.bounceAngle * dist2)
+            return true;
+
+        if (!changed.moved)
+            return false;
+
+        // Does the sphere cut the cone from p to the light? The cone widens from nothing at p to
+        // the light's radius at its center; dividing by the cosine of the half angle makes the
+        // test against the distance from the axis conservative.
+        for (const Bounds &light : lights) {
+            Vector3 axis = light.c - p;
+            double length = axis.len();
+            if (length <= light.r)
+                return true;
+            axis *= 1.0 / length;
+            double along = toChanged * axis;
+            if (along < -changed.r || along > length + changed.r)
+                continue;
+            double s = fmin(fmax(along, 0.0), length);
+            double offAxis = (toChanged - axis * s).len();
+            double slope = light.r / length;
+            if (offAxis <= (changed.r + slope * s) * sqrt(1.0 + slope * slope))
+                return true;
+        }
+        return false;
+    }
+
+    const TemporalRenderer::PixelHistory *TemporalRenderer::reproject(const Hit &hit, const Ray3 &ray,
+                                                                      const Matrix4 *inverseMotion,
+                                                                      const vector<Bounds> &changes,
+                                                                      const vector<Bounds> &lights) const {
+        double sx, sy;
+        Vector3 p = hit.p;
+        if (hit.prim >= 0) {
+            if (inverseMotion != nullptr)
+                p = inverseMotion->getTransformedVec(p);
+            for (const Bounds &c : changes) {
+                if (affects(c, hit.p, lights))
+                    return nullptr;
+            }
+            if (!camera.project(p, sx, sy))
+                return nullptr;
+        } else if (!camera.project(camera.eye + ray.d, sx, sy)) {
+            return nullptr;
+        }
+
+        int x = (int) floor(sx * settings.width);
+        int y = (int) floor(sy * settings.height);
+        if (x < 0 || y < 0 || x >= settings.width || y >= settings.height)
+            return nullptr;
+
+        const PixelHistory &h = history[(size_t) y * settings.width + x];
+        if (h.count == 0 || !h.uniform || h.prim != hit.prim)
+            return nullptr;
+        if (hit.prim >= 0) {
+            double depth = (p - camera.eye).len();
+            if (fabs(h.depth - depth) > temporal.depthTolerance * depth)
+                return nullptr;
+        }
+        return &h;
+    }
+
+    bool TemporalRenderer::anchored(const Camera &camera, const Vector3 &anchor, int x, int y) const {
+        double sx, sy;
+        if (!camera.project(anchor, sx, sy))
+            return false;
+        return fabs(sx * settings.width - (x + 0.5)) <= temporal.maxDrift &&
+               fabs(sy * settings.height - (y + 0.5)) <= temporal.maxDrift;
+    }
+
+    TemporalStats TemporalRenderer::renderFrame(const PreparedScene &scene, const Camera &camera,
+                                                const vector<Matrix4> *motion, FrameBuffer &out) {
+        auto start = chrono::steady_clock::now();
+        int width = settings.width, height = settings.height;
+        out.resize(width, height);
+
+        vector<PrimitiveState> state = stateOf(scene);
+        bool keep = hasHistory && state.size() == primitives.size() && scene.scene.background == background;
+
+        // A light that changed affects everything; anything else only what it shadows or lights.
+        vector<Bounds> changes, lights;
+        for (size_t i = 0; keep && i < state.size(); i++) {
+            const PrimitiveState &a = primitives[i], &b = state[i];
+            bool moved = !(a.c == b.c) || a.r != b.r;
+            if (!(a.material.emission == b.material.emission) ||
+                (moved && (a.material.isEmissive() || b.material.isEmissive()))) {
+                keep = false;
+            } else if (moved || !(a.material.albedo == b.material.albedo)) {
+                changes.push_back(Bounds{a.c, a.r, moved});
+                if (moved)
+                    changes.push_back(Bounds{b.c, b.r, true});
+            }
+            if (b.material.isEmissive())
+                lights.push_back(Bounds{b.c, b.r, false});
+        }
+
+        vector<Matrix4> inverseMotion;
+        if (keep && motion != nullptr && motion->size() == state.size()) {
+            inverseMotion.resize(motion->size());
+            for (size_t i = 0; i < motion->size(); i++)
+                inverseMotion[i] = (*motion)[i].getInverse();
+        }
+
+        next.assign((size_t) width * height, PixelHistory());
+        uint64_t seed = settings.seed + frame * 0x9E3779B97F4A7C15ull;
+        double inf = numeric_limits<double>::infinity();
+
+        vector<Tile> tiles = makeTiles(width, height, settings.tileSize);
+        int threads = resolveThreads(settings.threads);
+        vector<TemporalStats> counts((size_t) threads);
+        parallelFor(tiles.size(), threads, [&](size_t t, int worker) {
+            TraceSpan span("tile", "render", (int64_t) t);
+            TemporalStats &c = counts[worker];
+            const Tile &tile = tiles[t];
+            for (int y = tile.y0; y < tile.y1; y++) {
+                for (int x = tile.x0; x < tile.x1; x++) {
+                    size_t i = out.index(x, y);
+                    Ray3 center = camera.generateRay((x + 0.5) / width, (y + 0.5) / height);
+                    Hit hit;
+                    c.render.rays++;
+                    if (!scene.intersect(center, inf, hit))
+                        hit.prim = -1;
+
+                    PixelHistory &h = next[i];
+                    const PixelHistory *prev = nullptr;
+                    if (keep) {
+                        const Matrix4 *m = hit.prim >= 0 && !inverseMotion.empty() ? &inverseMotion[hit.prim] : nullptr;
+                        prev = reproject(hit, center, m, changes, lights);
+                    }
+                    Vector3 anchor = VEC_ZERO;
+                    if (prev != nullptr && hit.prim >= 0) {
+                        anchor = motion != nullptr && !inverseMotion.empty()
+                                 ? (*motion)[hit.prim].getTransformedVec(prev->anchor) : prev->anchor;
+                        if (!anchored(camera, anchor, x, y))
+                            prev = nullptr;
+                    }
+                    if (prev != nullptr && prev->age + 1 < temporal.maxAge) {
+                        h = *prev;
+                        h.anchor = anchor;
+                        h.age++;
+                    } else if (!keep) {
+                        h.age = (int) ((i * 2654435761u) % (uint64_t) temporal.maxAge);
+                    }
+                    h.prim = hit.prim;
+                    h.depth = hit.prim >= 0 ? hit.t : 0.0;
+
+                    if (h.count < settings.spp) {
+                        c.traced++;
+                        h.anchor = hit.p;
+                        for (int s = h.count; s < settings.spp; s++) {
+                            Sampler sampler(seed, i, (uint64_t) s);
+                            double sx = (x + sampler.next1D()) / width;
+                            double sy = (y + sampler.next1D()) / height;
+                            Hit first;
+                            Vector3 color = Renderer::trace(scene, camera.generateRay(sx, sy), sampler,
+                                                            settings.maxDepth, &first, c.render.rays);
+                            h.uniform &= first.prim == hit.prim;
+                            double l = luminance(color);
+                            h.sum += color;
+                            h.lum += l;
+                            h.lum2 += l * l;
+                        }
+                        h.count = settings.spp;
+                    } else {
+                        c.reused++;
+                    }
+
+                    double inv = 1.0 / h.count;
+                    double mean = h.lum * inv;
+                    out.color[i] = h.sum * inv;
+                    out.variance[i] = max(0.0, h.lum2 * inv - mean * mean) * inv;
+                    out.albedo[i] = hit.prim >= 0 ? scene.scene.materials[hit.prim].albedo : Vector3(1.0, 1.0, 1.0);
+                    out.emission[i] = hit.prim >= 0 ? scene.scene.materials[hit.prim].emission : VEC_ZERO;
+                    out.normal[i] = hit.prim >= 0 ? hit.n : VEC_ZERO;
+                    out.depth[i] = h.depth;
+                }
+            }
+        });
+
+        history.swap(next);
+        this->camera = camera;
+        primitives.swap(state);
+        background = scene.scene.background;
+        hasHistory = true;
+        frame++;
+
+        TemporalStats stats;
+        for (const TemporalStats &c : counts) {
+            stats.render.rays += c.render.rays;
+            stats.reused += c.reused;
+            stats.traced += c.traced;
+        }
+        stats.render.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        return stats;
+    }
+}
@@ -0,0 +1,163 @@
+#ifndef RAYTRACER_C_TEMPORAL_H
+#define RAYTRACER_C_TEMPORAL_H
+
+#include "../math/mat4.h"
+#include "renderer.h"
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+namespace bla {
+    /**
+     * Options for reusing samples across the frames of an animation.
+     */
+    struct TemporalSettings {
+        /**Frames a pixel's samples may be reused before the pixel is traced again*/
+        int maxAge = 16;
+        /**Relative difference in depth above which a reprojected pixel counts as disoccluded*/
+        double depthTolerance = 0.05;
+        /**
+         * Distance in pixels, per axis, that the center of the footprint a pixel's samples
+         * were taken over may have drifted from the pixel center before they are discarded
+         */
+        double maxDrift = 0.5;
+        /**
+         * Pixels that see a primitive which moved or changed material under a larger angle
+         * than this, given as the sine of the angular radius, get new samples, since the
+         * light it bounces onto them changes with it. Shadows do not depend on this
+         */
+        double bounceAngle = 0.25;
+    };
+
+    /**
+     * What rendering one frame of an animation did.
+     */
+    struct TemporalStats {
+        RenderStats render;
+        /**Pixels whose samples were all carried over from the previous frame*/
+        size_t reused = 0;
+        /**Pixels that got new samples*/
+        size_t traced = 0;
+    };
+
+    /**
+     * Renders the frames of an animation, carrying each pixel's accumulated samples over to
+     * the next frame wherever the same surface is still visible and its lighting has not
+     * changed.
+     * <p>
+     * Every frame traces one ray through each pixel center to find what is visible now. The
+     * hit point is moved back along the motion of its primitive and projected into the
+     * previous camera; if the pixel it lands on saw the same primitive at the same depth,
+     * and nothing else, that pixel's samples are reused. Pixels on silhouettes, whose
+     * samples mix several surfaces, would smear those across the image as the camera moves,
+     * so they are traced every frame. Only pixels without usable history get new samples.
+     * </p>
+     * <p>
+     * History is rejected
+     * <ul>
+     * <li>everywhere if the lights or the background change;</li>
+     * <li>on pixels whose direct light a primitive that moved blocks now or blocked
+     * before, i.e. whose old or new sphere cuts the cone from the shaded point to a light,
+     * however far it is from the point. This follows long cast shadows;</li>
+     * <li>on pixels that see a primitive that moved or changed material under a large angle,
+     * see <code>TemporalSettings::bounceAngle</code>. Diffuse shading depends on position, so
+     * this includes the surface of a primitive that was translated; primitives that only
+     * rotate in place keep theirs;</li>
+     * <li>if the samples were taken around a point that has drifted out of the pixel, see
+     * <code>TemporalSettings::maxDrift</code>;</li>
+     * <li>on pixels whose history is older than <code>TemporalSettings::maxAge</code> frames,
+     * so that reprojection errors cannot build up. Ages start out staggered so that the
+     * pixels of the first frame do not all expire at once.</li>
+     * </ul>
+     * </p>
+     */
+    class TemporalRenderer {
+    private:
+        struct PixelHistory {
+            Vector3 sum = VEC_ZERO;
+            double lum = 0.0, lum2 = 0.0;
+            int count = 0;
+            int age = 0;
+            /**Primitive seen through the pixel center, or -1*/
+            int prim = -1;
+            /**Distance from the eye to that primitive*/
+            double depth = 0.0;
+            /**
+             * Where the pixel center hit when the samples were taken, moved along with its
+             * primitive since. Reprojection snaps to the nearest pixel, so without it the
+             * footprint of reused samples would wander off a little more every frame
+             */
+            Vector3 anchor = VEC_ZERO;
+            /**Whether every sample saw <b>prim</b>; pixels on silhouettes are never reused*/
+            bool uniform = true;
+        };
+
+        /**What the shading of a primitive depends on*/
+        struct PrimitiveState {
+            Vector3 c;
+            double r;
+            Material material;
+        };
+
+        /**The bounding sphere of a primitive that changed, or of a light*/
+        struct Bounds {
+            Vector3 c;
+            double r;
+            /**Whether the primitive moved, so its shadow did too, rather than only changed color*/
+            bool moved;
+        };
+
+        RenderSettings settings;
+        TemporalSettings temporal;
+        uint64_t frame = 0;
+        bool hasHistory = false;
+        Camera camera;
+        Vector3 background;
+        vector<PrimitiveState> primitives;
+        vector<PixelHistory> history, next;
+
+        static vector<PrimitiveState> stateOf(const PreparedScene &scene);
+
+        const PixelHistory *reproject(const Hit &hit, const Ray3 &ray, const Matrix4 *inverseMotion,
+                                      const vector<Bounds> &changes, const vector<Bounds> &lights) const;
+
+        /**
+         * @return whether a change to the primitive <b>changed</b> can change the light that
+         * reaches <b>p</b>: directly, through the shadow it casts from any of <b>lights</b>,
+         * or by bouncing light onto it
+         */
+        bool affects(const Bounds &changed, const Vector3 &p, const vector<Bounds> &lights) const;
+
+        bool anchored(const Camera &camera, const Vector3 &anchor, int x, int y) const;
+
+    public:
+        /**
+         * @param settings the options for every frame; <b>region</b> is ignored
+         * @param temporal the options for reusing samples
+         */
+        explicit TemporalRenderer(const RenderSettings &settings, const TemporalSettings &temporal = TemporalSettings())
+                : settings(settings), temporal(temporal) {}
+
+        /**
+         * Renders the next frame.
+         *
+         * @param scene the scene as it is in this frame
+         * @param camera the camera of this frame
+         * @param motion if not <code>nullptr</code>, for every primitive the transform from its
+         *               pose in the previous frame to its pose in this one. Without it,
+         *               primitives are assumed not to rotate
+         * @param out receives the image and AOVs. The AOVs describe the pixel centers
+         * @return the rays traced and how many pixels were reused
+         */
+        TemporalStats renderFrame(const PreparedScene &scene, const Camera &camera, const vector<Matrix4> *motion,
+                                  FrameBuffer &out);
+
+        /**
+         * Forgets all history, e.g. at a cut.
+         */
+        void reset() {
+            hasHistory = false;
+        }
+    };
+}
+#endif //RAYTRACER_C_TEMPORAL_H
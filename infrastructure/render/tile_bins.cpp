@@ -0,0 +1,96 @@
+/**
+* TileBins implementation
+*/
+
+#include "tile_bins.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace bla {
+    namespace {
+        /**
+         * Finds the planes <code>x = a z</code> (in camera space) that touch a sphere with
+         * center <code>(x, z)</code> and radius <b>r</b>, with <code>z > r</code>. The planes
+         * that meet the sphere are those with <b>a</b> between the two.
+         */
+        void tangentPlanes(double x, double z, double r, double &lo, double &hi) {
+            double d = z * z - r * r;
+            double s = r * sqrt(x * x + d);
+            lo = (x * z - s) / d;
+            hi = (x * z + s) / d;
+        }
+
+        /**
+         * @return the tile column or row containing pixel coordinate <b>p</b>, clamped to
+         * <code>[-1, count]</code>
+         */
+        int tileOf(double p, int origin, int tileSize, int count) {
+            double t = floor((p - origin) / tileSize);
+            return (int) max(-1.0, min((double) count, t));
+        }
+    }
+
+    TileBins::TileBins(const PrimitiveStore &store, const Camera &camera, int width, int height,
+                       const Tile &region, int tileSize) {
+        TraceSpan span("tile bins", "build");
+        int columns = max(0, (region.x1 - region.x0 + tileSize - 1) / tileSize);
+        int rows = max(0, (region.y1 - region.y0 + tileSize - 1) / tileSize);
+        offsets.assign((size_t) columns * rows + 1, 0);
+
+        Vector3 u, v, w;
+        camera.basis(u, v, w);
+        double h = tan(camera.fov * M_PI / 360.0);
+        double hx = h * camera.aspect;
+
+        // Inclusive ranges of tile columns and rows covered by each primitive.
+        struct Span {
+            int c0, c1, r0, r1;
+        };
+        vector<Span> spans(store.size());
+
+        for (uint32_t prim = 0; prim < store.size(); prim++) {
+            Vector3 c;
+            double r;
+            store.boundingSphere(prim, c, r);
+            Vector3 p = c - camera.eye;
+            double x = p * u, y = p * v, z = p * w;
+
+            Span s = {0, columns - 1, 0, rows - 1};
+            if (z < -r) {
+                // Entirely behind the eye, where no camera ray goes: in no tile at all.
+                s = {0, -1, 0, -1};
+            } else if (z > r) {
+                // Screen x grows with a, screen y shrinks with it; a pixel of slack on each
+                // side absorbs rounding in the camera and in the packed geometry.
+                double lo, hi;
+                tangentPlanes(x, z, r, lo, hi);
+                s.c0 = max(0, tileOf((lo / hx + 1.0) * 0.5 * width - 1.0, region.x0, tileSize, columns));
+                s.c1 = min(columns - 1, tileOf((hi / hx + 1.0) * 0.5 * width + 1.0, region.x0, tileSize, columns));
+                tangentPlanes(y, z, r, lo, hi);
+                s.r0 = max(0, tileOf((1.0 - hi / h) * 0.5 * height - 1.0, region.y0, tileSize, rows));
+                s.r1 = min(rows - 1, tileOf((1.0 - lo / h) * 0.5 * height + 1.0, region.y0, tileSize, rows));
+            }
+            spans[prim] = s;
+
+            for (int row = s.r0; row <= s.r1; row++)
+                for (int col = s.c0; col <= s.c1; col++)
+                    offsets[row * columns + col + 1]++;
+        }
+
+        for (size_t t = 1; t < offsets.size(); t++)
+            offsets[t] += offsets[t - 1];
+        ids.resize(offsets.back());
+
+        // Filling in primitive order keeps every list sorted.
+        vector<uint32_t> next(offsets.begin(), offsets.end() - 1);
+        for (uint32_t prim = 0; prim < store.size(); prim++) {
+            const Span &s = spans[prim];
+            for (int row = s.r0; row <= s.r1; row++)
+                for (int col = s.c0; col <= s.c1; col++)
+                    ids[next[row * columns + col]++] = prim;
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef RAYTRACER_C_TILE_BINS_H
+#define RAYTRACER_C_TILE_BINS_H
+
+#include "camera.h"
+#include "primitive_store.h"
+#include "tiles.h"
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+namespace bla {
+    /**
+     * For every tile of an image, the primitives that primary rays through the tile can hit.
+     * <p>
+     * The camera rays through one column of pixels all lie in a plane through the eye, and
+     * so do the rays through one row. The frustum of a tile is bounded by two column planes
+     * and two row planes, so a primitive overlaps it exactly when its bounding sphere meets
+     * the tile's range of column planes and its range of row planes. Both ranges come from
+     * the planes tangent to the sphere, which makes binning a primitive cost a few square
+     * roots plus one write per tile it covers. Primitives that lie entirely behind the eye
+     * are put into no tile, and those that straddle it into every tile.
+     * </p>
+     */
+    class TileBins {
+    private:
+        /**Offset of each tile's list in <b>ids</b>, plus the total at the end*/
+        vector<uint32_t> offsets;
+        vector<uint32_t> ids;
+
+    public:
+        TileBins() {}
+
+        /**
+         * Bins the primitives of a store for the tiles <code>makeTiles(region, tileSize)</code>.
+         *
+         * @param store the primitives
+         * @param camera the camera the primary rays come from
+         * @param width the image width in pixels
+         * @param height the image height in pixels
+         * @param region the part of the image that is rendered
+         * @param tileSize the tile edge length in pixels
+         */
+        TileBins(const PrimitiveStore &store, const Camera &camera, int width, int height, const Tile &region,
+                 int tileSize);
+
+        /**
+         * @return the primitives primary rays through tile <b>tile</b> can hit, in ascending order
+         */
+        PrimitiveList candidates(int tile) const {
+            return PrimitiveList{ids.data() + offsets[tile], offsets[tile + 1] - offsets[tile]};
+        }
+
+        /**
+         * @return the total length of all lists
+         */
+        size_t size() const {
+            return ids.size();
+        }
+    };
+}
+#endif //RAYTRACER_C_TILE_BINS_H
@@ -0,0 +1,85 @@
+#ifndef RAYTRACER_C_TILES_H
+#define RAYTRACER_C_TILES_H
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+using namespace std;
+namespace bla {
+    /**
+     * A rectangular block of pixels, <code>[x0, x1) x [y0, y1)</code>.
+     */
+    struct Tile {
+        int x0, y0, x1, y1;
+        /**Position of the tile in the list returned by <code>makeTiles</code>*/
+        int index;
+
+        int width() const { return x1 - x0; }
+
+        int height() const { return y1 - y0; }
+    };
+
+    /**
+     * Splits a region of an image into square tiles, in row major order. Tiles on the
+     * right and bottom edges of the region may be smaller.
+     */
+    inline vector<Tile> makeTiles(const Tile &region, int tileSize) {
+        vector<Tile> tiles;
+        for (int y = region.y0; y < region.y1; y += tileSize) {
+            for (int x = region.x0; x < region.x1; x += tileSize) {
+                Tile t = {x, y, min(x + tileSize, region.x1), min(y + tileSize, region.y1), (int) tiles.size()};
+                tiles.push_back(t);
+            }
+        }
+        return tiles;
+    }
+
+    /**
+     * Splits an image into square tiles, in row major order. Tiles on the right and
+     * bottom edges may be smaller.
+     */
+    inline vector<Tile> makeTiles(int width, int height, int tileSize) {
+        return makeTiles(Tile{0, 0, width, height, 0}, tileSize);
+    }
+
+    /**
+     * @param requested the requested number of threads, or 0 for one per hardware thread
+     * @return the number of worker threads to use
+     */
+    inline int resolveThreads(int requested) {
+        if (requested > 0)
+            return requested;
+        unsigned int n = thread::hardware_concurrency();
+        return n == 0 ? 1 : (int) n;
+    }
+
+    /**
+     * Runs <code>fn(i, worker)</code> for every <code>i</code> in <code>[0, count)</code>.
+     * Work items are handed out dynamically so uneven tiles balance out. The calling
+     * thread is used as worker 0.
+     *
+     * @param count the number of work items
+     * @param threads the number of workers, or 0 for one per hardware thread
+     * @param fn the work to do
+     */
+    inline void parallelFor(size_t count, int threads, const function<void(size_t, int)> &fn) {
+        int n = min(resolveThreads(threads), (int) max<size_t>(count, 1));
+        atomic<size_t> next(0);
+
+        auto worker = [&](int id) {
+            for (size_t i = next++; i < count; i = next++)
+                fn(i, id);
+        };
+
+        vector<thread> pool;
+        for (int i = 1; i < n; i++)
+            pool.emplace_back(worker, i);
+        worker(0);
+        for (thread &t : pool)
+            t.join();
+    }
+}
+#endif //RAYTRACER_C_TILES_H
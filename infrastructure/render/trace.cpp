@@ -0,0 +1,165 @@
+/**
+* Trace implementation
+*/
+
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+namespace bla {
+    namespace {
+        /**
+         * The spans of one thread at a time. Only the owning thread writes to it, so it needs
+         * no locks; <b>head</b> counts every span ever recorded, and the newest
+         * <code>events.size()</code> of them are kept.
+         */
+        struct TraceRing {
+            vector<TraceEvent> events;
+            uint64_t head = 0;
+            /**Track the ring shows up as*/
+            int tid;
+
+            TraceRing(size_t capacity, int tid) : events(capacity), tid(tid) {}
+        };
+
+        mutex ringsLock;
+        vector<unique_ptr<TraceRing>> rings;
+        /**Rings whose thread exited, ready for the next thread to claim*/
+        vector<TraceRing *> freeRings;
+        size_t ringCapacity = Trace::RING_EVENTS;
+        chrono::steady_clock::time_point epoch = chrono::steady_clock::now();
+
+        /**
+         * Hands the ring of a thread back when the thread exits.
+         */
+        struct RingClaim {
+            TraceRing *ring = nullptr;
+
+            ~RingClaim() {
+                if (ring != nullptr) {
+                    lock_guard<mutex> l(ringsLock);
+                    freeRings.push_back(ring);
+                }
+            }
+        };
+
+        thread_local RingClaim claim;
+
+        TraceRing &ringOfThisThread() {
+            if (claim.ring == nullptr) {
+                lock_guard<mutex> l(ringsLock);
+                if (!freeRings.empty()) {
+                    claim.ring = freeRings.back();
+                    freeRings.pop_back();
+                } else {
+                    rings.emplace_back(new TraceRing(ringCapacity, (int) rings.size() + 1));
+                    claim.ring = rings.back().get();
+                }
+            }
+            return *claim.ring;
+        }
+
+        void appendString(string &out, const char *s) {
+            out += '"';
+            for (; *s != '\0'; s++) {
+                if (*s == '"' || *s == '\\')
+                    out += '\\';
+                out += *s;
+            }
+            out += '"';
+        }
+
+        /**
+         * @return <b>ns</b> in microseconds, the unit of Chrome trace timestamps
+         */
+        string micros(uint64_t ns) {
+            char text[32];
+            snprintf(text, sizeof(text), "%llu.%03llu", (unsigned long long) (ns / 1000),
+                     (unsigned long long) (ns % 1000));
+            return text;
+        }
+    }
+
+    atomic<bool> Trace::on(false);
+
+    void Trace::start(size_t ringEvents) {
+        // An empty ring would have no slot to record into.
+        ringEvents = max<size_t>(ringEvents, 1);
+        lock_guard<mutex> l(ringsLock);
+        ringCapacity = ringEvents;
+        for (unique_ptr<TraceRing> &ring : rings) {
+            ring->events.assign(ringEvents, TraceEvent());
+            ring->head = 0;
+        }
+        epoch = chrono::steady_clock::now();
+        on.store(true, memory_order_relaxed);
+    }
+
+    void Trace::stop() {
+        on.store(false, memory_order_relaxed);
+    }
+
+    uint64_t Trace::now() {
+        return (uint64_t) chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - epoch).count();
+    }
+
+    void Trace::record(const char *name, const char *category, uint64_t start, int64_t index) {
+        TraceRing &ring = ringOfThisThread();
+        TraceEvent &e = ring.events[ring.head % ring.events.size()];
+        e.name = name;
+        e.category = category;
+        e.index = index;
+        e.start = start;
+        e.duration = now() - start;
+        ring.head++;
+    }
+
+    string Trace::json() {
+        lock_guard<mutex> l(ringsLock);
+        string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+        for (const unique_ptr<TraceRing> &ring : rings) {
+            if (ring->head == 0)
+                continue;
+            string tid = to_string(ring->tid);
+            out += first ? "\n" : ",\n";
+            first = false;
+            out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + tid +
+                   ",\"args\":{\"name\":\"thread " + tid + "\"}}";
+
+            size_t size = ring->events.size();
+            uint64_t oldest = ring->head > size ? ring->head - size : 0;
+            for (uint64_t i = oldest; i < ring->head; i++) {
+                const TraceEvent &e = ring->events[i % size];
+                out += ",\n{\"name\":";
+                appendString(out, e.name);
+                out += ",\"cat\":";
+                appendString(out, e.category);
+                out += ",\"ph\":\"X\",\"pid\":1,\"tid\":" + tid + ",\"ts\":" + micros(e.start) +
+                       ",\"dur\":" + micros(e.duration);
+                if (e.index >= 0)
+                    out += ",\"args\":{\"index\":" + to_string(e.index) + "}";
+                out += "}";
+            }
+        }
+        out += "\n]}\n";
+        return out;
+    }
+
+    bool Trace::write(const string &path, string &error) {
+        ofstream out(path, ios::binary);
+        out << json();
+        if (!out) {
+            error = "could not write " + path;
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,117 @@
+#ifndef RAYTRACER_C_TRACE_H
+#define RAYTRACER_C_TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+using namespace std;
+namespace bla {
+    /**
+     * One finished span. Times are in nanoseconds since <code>Trace::start</code>.
+     */
+    struct TraceEvent {
+        /**Static strings; only the pointers are recorded*/
+        const char *name = nullptr;
+        const char *category = nullptr;
+        /**Shown as the <b>index</b> argument if not negative, e.g. the tile a span rendered*/
+        int64_t index = -1;
+        uint64_t start = 0;
+        uint64_t duration = 0;
+    };
+
+    /**
+     * Timeline profiling of the render threads, written as Chrome trace JSON that
+     * <code>chrome://tracing</code> and Perfetto open. Spans show stalls, load imbalance and
+     * serial sections that the totals in <code>RenderStats</code> hide.
+     * <p>
+     * Each thread records into a ring buffer of its own, so recording takes no locks and
+     * keeps the newest spans once the ring is full. A thread claims a ring on its first span
+     * and hands it back when it exits, so the short lived workers of successive
+     * <code>parallelFor</code> calls reuse the same few rings, which show up as one track each.
+     * </p>
+     * <p>
+     * Tracing is off until <code>start</code>; until then a <code>TraceSpan</code> costs one
+     * relaxed atomic load.
+     * </p>
+     */
+    class Trace {
+    private:
+        static atomic<bool> on;
+
+    public:
+        /**Spans kept per thread by default*/
+        static const size_t RING_EVENTS = 1 << 16;
+
+        /**
+         * Discards everything recorded so far and starts recording, keeping the newest
+         * <b>ringEvents</b> spans of every thread, but at least one. Must not race with spans
+         * being recorded.
+         */
+        static void start(size_t ringEvents = RING_EVENTS);
+
+        /**
+         * Stops recording; what was recorded is kept for <code>json</code> and <code>write</code>.
+         */
+        static void stop();
+
+        static bool enabled() {
+            return on.load(memory_order_relaxed);
+        }
+
+        /**
+         * @return nanoseconds since <code>start</code>
+         */
+        static uint64_t now();
+
+        /**
+         * Records a span that began at <b>start</b> and ends now, in the ring of the calling thread.
+         */
+        static void record(const char *name, const char *category, uint64_t start, int64_t index);
+
+        /**
+         * @return the recorded spans as Chrome trace JSON, oldest first on every thread. Like
+         * <code>start</code>, this must not race with spans being recorded.
+         */
+        static string json();
+
+        /**
+         * Writes <code>json()</code> to <b>path</b>.
+         *
+         * @return <b>false</b> with a message in <b>error</b> if the file could not be written
+         */
+        static bool write(const string &path, string &error);
+    };
+
+    /**
+     * Records the time from its construction to its destruction as a span, if tracing is on:
+     * <pre>
+     *     TraceSpan span("denoise", "post");
+     * </pre>
+     * <b>name</b> and <b>category</b> must be string literals or otherwise outlive the trace.
+     */
+    class TraceSpan {
+    private:
+        const char *name;
+        const char *category;
+        int64_t index;
+        uint64_t begin = 0;
+        bool active;
+
+    public:
+        TraceSpan(const char *name, const char *category, int64_t index = -1)
+                : name(name), category(category), index(index), active(Trace::enabled()) {
+            if (active)
+                begin = Trace::now();
+        }
+
+        TraceSpan(const TraceSpan &) = delete;
+        TraceSpan &operator=(const TraceSpan &) = delete;
+
+        ~TraceSpan() {
+            if (active)
+                Trace::record(name, category, begin, index);
+        }
+    };
+}
+#endif //RAYTRACER_C_TRACE_H
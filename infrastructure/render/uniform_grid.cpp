@@ -0,0 +1,260 @@
+/**
+* UniformGrid implementation
+*/
+
+#include "uniform_grid.h"
+#include "tiles.h"
+#include "trace.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+namespace bla {
+    namespace {
+        /**Primitives handed to a build worker at a time*/
+        const size_t CHUNK = 4096;
+
+        /**
+         * The cells a binned primitive's bounding box overlaps, <b>first</b> to <b>last</b> on each axis.
+         */
+        struct Footprint {
+            uint32_t prim;
+            uint16_t first[3], last[3];
+        };
+
+        /**
+         * @return the radius of every primitive of <b>store</b>, with centers in <b>centers</b>
+         */
+        vector<double> boundsOf(const PrimitiveStore &store, vector<Vector3> &centers) {
+            vector<double> radii(store.size());
+            centers.resize(store.size());
+            for (uint32_t i = 0; i < store.size(); i++)
+                store.boundingSphere(i, centers[i], radii[i]);
+            return radii;
+        }
+
+        /**
+         * @return the largest radius that is still binned, see <code>GridSettings::outlierRadii</code>
+         */
+        double outlierLimit(vector<double> radii, const GridSettings &settings) {
+            if (radii.empty())
+                return 0.0;
+            auto median = radii.begin() + radii.size() / 2;
+            nth_element(radii.begin(), median, radii.end());
+            return *median * settings.outlierRadii;
+        }
+    }
+
+    bool UniformGrid::suits(const PrimitiveStore &store, const GridSettings &settings) {
+        if (store.size() < settings.minPrimitives)
+            return false;
+        vector<Vector3> centers;
+        vector<double> radii = boundsOf(store, centers);
+        double limit = outlierLimit(radii, settings);
+        size_t outliers = (size_t) count_if(radii.begin(), radii.end(), [&](double r) { return r > limit; });
+        return outliers <= store.size() / 16;
+    }
+
+    UniformGrid::UniformGrid(const PrimitiveStore &store, const GridSettings &settings) {
+        TraceSpan span("uniform grid", "build");
+        vector<Vector3> centers;
+        vector<double> radii = boundsOf(store, centers);
+        double limit = outlierLimit(radii, settings);
+
+        vector<uint32_t> binned;
+        binned.reserve(store.size());
+        for (uint32_t i = 0; i < store.size(); i++) {
+            if (radii[i] > limit)
+                outliers.push_back(i);
+            else
+                binned.push_back(i);
+        }
+
+        double inf = numeric_limits<double>::infinity();
+        Vector3 hi(-inf, -inf, -inf);
+        lo = Vector3(inf, inf, inf);
+        for (uint32_t i : binned) {
+            const Vector3 &c = centers[i];
+            double r = radii[i];
+            lo = Vector3(min(lo.x, c.x - r), min(lo.y, c.y - r), min(lo.z, c.z - r));
+            hi = Vector3(max(hi.x, c.x + r), max(hi.y, c.y + r), max(hi.z, c.z + r));
+        }
+        if (binned.empty())
+            lo = hi = VEC_ZERO;
+
+        // Cells as close to cubes as the bounds allow, cellsPerPrimitive of them per primitive.
+        double extent[3] = {hi.x - lo.x, hi.y - lo.y, hi.z - lo.z};
+        double volume = max(extent[0], 1e-9) * max(extent[1], 1e-9) * max(extent[2], 1e-9);
+        double perUnit = cbrt(max(1.0, settings.cellsPerPrimitive * binned.size()) / volume);
+        double size[3];
+        for (int a = 0; a < 3; a++) {
+            res[a] = (int) min((double) settings.maxResolution, max(1.0, ceil(extent[a] * perUnit)));
+            size[a] = extent[a] > 0.0 ? extent[a] / res[a] : 1.0;
+        }
+        cellSize = Vector3(size[0], size[1], size[2]);
+        size_t cells = (size_t) res[0] * res[1] * res[2];
+
+        double inverse[3] = {1.0 / size[0], 1.0 / size[1], 1.0 / size[2]};
+        auto cellIndex = [&](int x, int y, int z) {
+            return ((size_t) z * res[1] + y) * res[0] + x;
+        };
+        auto forEachChunk = [&](size_t count, const function<void(size_t)> &fn) {
+            parallelFor((count + CHUNK - 1) / CHUNK, settings.threads, [&](size_t chunk, int) {
+                size_t end = min(count, (chunk + 1) * CHUNK);
+                for (size_t k = chunk * CHUNK; k < end; k++)
+                    fn(k);
+            });
+        };
+        vector<atomic<uint32_t>> counts(cells);
+        auto clearCounts = [&]() {
+            for (atomic<uint32_t> &c : counts)
+                c.store(0, memory_order_relaxed);
+        };
+        // Turns the counts into offsets in place, and returns the total.
+        auto countsToOffsets = [&](vector<uint32_t> *keep) {
+            uint32_t total = 0;
+            for (size_t i = 0; i < cells; i++) {
+                uint32_t n = counts[i].load(memory_order_relaxed);
+                if (keep != nullptr)
+                    (*keep)[i] = total;
+                counts[i].store(total, memory_order_relaxed);
+                total += n;
+            }
+            return total;
+        };
+
+        vector<Footprint> footprints(binned.size());
+        clearCounts();
+        forEachChunk(binned.size(), [&](size_t k) {
+            uint32_t prim = binned[k];
+            const Vector3 &c = centers[prim];
+            double r = radii[prim];
+            double cl[3] = {c.x - r - lo.x, c.y - r - lo.y, c.z - r - lo.z};
+            double ch[3] = {c.x + r - lo.x, c.y + r - lo.y, c.z + r - lo.z};
+            Footprint &f = footprints[k];
+            f.prim = prim;
+            for (int a = 0; a < 3; a++) {
+                f.first[a] = (uint16_t) max(0, min(res[a] - 1, (int) floor(cl[a] * inverse[a])));
+                f.last[a] = (uint16_t) max(0, min(res[a] - 1, (int) floor(ch[a] * inverse[a])));
+            }
+            counts[cellIndex(f.first[0], f.first[1], f.first[2])].fetch_add(1, memory_order_relaxed);
+        });
+
+        // Order the primitives by their first cell, so that the passes below sweep the cells
+        // front to back instead of jumping around memory; this more than halves the build.
+        countsToOffsets(nullptr);
+        vector<Footprint> ordered(footprints.size());
+        forEachChunk(footprints.size(), [&](size_t k) {
+            const Footprint &f = footprints[k];
+            ordered[counts[cellIndex(f.first[0], f.first[1], f.first[2])].fetch_add(1, memory_order_relaxed)] = f;
+        });
+        footprints.clear();
+        footprints.shrink_to_fit();
+
+        // Count, offset, scatter.
+        clearCounts();
+        forEachChunk(ordered.size(), [&](size_t k) {
+            const Footprint &f = ordered[k];
+            for (int z = f.first[2]; z <= f.last[2]; z++)
+                for (int y = f.first[1]; y <= f.last[1]; y++)
+                    for (int x = f.first[0]; x <= f.last[0]; x++)
+                        counts[cellIndex(x, y, z)].fetch_add(1, memory_order_relaxed);
+        });
+        offsets.resize(cells + 1);
+        offsets[cells] = countsToOffsets(&offsets);
+        ids.resize(offsets[cells]);
+        forEachChunk(ordered.size(), [&](size_t k) {
+            const Footprint &f = ordered[k];
+            for (int z = f.first[2]; z <= f.last[2]; z++)
+                for (int y = f.first[1]; y <= f.last[1]; y++)
+                    for (int x = f.first[0]; x <= f.last[0]; x++)
+                        ids[counts[cellIndex(x, y, z)].fetch_add(1, memory_order_relaxed)] = f.prim;
+        });
+
+        // The scatter order depends on thread timing; sorting makes the lists, and with
+        // them the order hits are found in, deterministic.
+        parallelFor((cells + CHUNK - 1) / CHUNK, settings.threads, [&](size_t chunk, int) {
+            size_t end = min(cells, (chunk + 1) * CHUNK);
+            for (size_t i = chunk * CHUNK; i < end; i++)
+                sort(ids.begin() + offsets[i], ids.begin() + offsets[i + 1]);
+        });
+    }
+
+    bool UniformGrid::intersect(const PrimitiveStore &store, const Ray3 &ray, double tMax, Hit &hit) const {
+        hit.t = tMax;
+        hit.prim = -1;
+        bool found = false;
+        Hit h;
+        if (!outliers.empty() && store.intersect(PrimitiveList{outliers.data(), outliers.size()}, ray, tMax, h)) {
+            hit = h;
+            found = true;
+        }
+
+        // Clip the ray to the grid bounds.
+        double o[3] = {ray.o.x - lo.x, ray.o.y - lo.y, ray.o.z - lo.z};
+        double d[3] = {ray.d.x, ray.d.y, ray.d.z};
+        double size[3] = {cellSize.x, cellSize.y, cellSize.z};
+        double t0 = 0.0, t1 = hit.t;
+        for (int a = 0; a < 3; a++) {
+            double extent = size[a] * res[a];
+            if (d[a] == 0.0) {
+                if (o[a] < 0.0 || o[a] > extent)
+                    return found;
+                continue;
+            }
+            double tNear = -o[a] / d[a], tFar = (extent - o[a]) / d[a];
+            if (tNear > tFar)
+                swap(tNear, tFar);
+            t0 = max(t0, tNear);
+            t1 = min(t1, tFar);
+        }
+        if (t0 > t1)
+            return found;
+
+        // Set up the walk from the cell the clipped ray starts in.
+        int cell[3], step[3], stop[3];
+        double next[3], delta[3];
+        double inf = numeric_limits<double>::infinity();
+        for (int a = 0; a < 3; a++) {
+            double p = o[a] + d[a] * t0;
+            cell[a] = max(0, min(res[a] - 1, (int) floor(p / size[a])));
+            if (d[a] > 0.0) {
+                next[a] = ((cell[a] + 1) * size[a] - o[a]) / d[a];
+                delta[a] = size[a] / d[a];
+                step[a] = 1;
+                stop[a] = res[a];
+            } else if (d[a] < 0.0) {
+                next[a] = (cell[a] * size[a] - o[a]) / d[a];
+                delta[a] = -size[a] / d[a];
+                step[a] = -1;
+                stop[a] = -1;
+            } else {
+                next[a] = delta[a] = inf;
+                step[a] = 0;
+                stop[a] = -1;
+            }
+        }
+
+        for (;;) {
+            size_t i = ((size_t) cell[2] * res[1] + cell[1]) * res[0] + cell[0];
+            uint32_t count = offsets[i + 1] - offsets[i];
+            if (count > 0 && store.intersect(PrimitiveList{ids.data() + offsets[i], count}, ray, hit.t, h)) {
+                hit = h;
+                found = true;
+            }
+
+            int a = next[0] < next[1] ? (next[0] < next[2] ? 0 : 2) : (next[1] < next[2] ? 1 : 2);
+            // Everything beyond this cell is farther than the closest hit.
+            if (hit.t <= next[a] || t1 <= next[a])
+                break;
+            cell[a] += step[a];
+            if (cell[a] == stop[a])
+                break;
+            next[a] += delta[a];
+        }
+        return found;
+    }
+}
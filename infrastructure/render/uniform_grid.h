@@ -0,0 +1,119 @@
+#ifndef RAYTRACER_C_UNIFORM_GRID_H
+#define RAYTRACER_C_UNIFORM_GRID_H
+
+#include "../math/ray.h"
+#include "primitive_store.h"
+#include "scene.h"
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+namespace bla {
+    /**
+     * How a <code>PreparedScene</code> finds the primitives a ray can hit.
+     */
+    enum class Accelerator : uint8_t {
+        /**Pick from the scene statistics, see <code>UniformGrid::suits</code>*/
+        Auto,
+        /**Test every primitive; best for a handful of them*/
+        None,
+        /**A <code>UniformGrid</code>*/
+        Grid
+    };
+
+    /**
+     * Options for building a <code>UniformGrid</code>.
+     */
+    struct GridSettings {
+        /**Fewest primitives for which <code>Accelerator::Auto</code> builds a grid*/
+        size_t minPrimitives = 64;
+        /**Cells per binned primitive; the grid resolution follows from it*/
+        double cellsPerPrimitive = 2.0;
+        /**
+         * Primitives with a radius above this many times the median radius are not binned
+         * but tested by every ray, like a ground plane made of one huge sphere
+         */
+        double outlierRadii = 8.0;
+        /**Largest number of cells along any axis, at most 65535*/
+        int maxResolution = 512;
+        /**Worker threads for the build, or 0 for one per hardware thread*/
+        int threads = 0;
+    };
+
+    /**
+     * A uniform grid over the primitives of a <code>PrimitiveStore</code>, for scenes of many
+     * similar sized primitives spread fairly evenly, such as particle simulations.
+     * <p>
+     * Every primitive is listed in each cell its bounding box overlaps. Building is a
+     * parallel counting sort: count the primitives per cell, turn the counts into offsets,
+     * then scatter the ids, which costs a few passes over the primitives and no recursion,
+     * so the grid can be rebuilt every frame of a simulation. A ray walks the cells it
+     * passes through front to back (3D-DDA, Amanatides and Woo 1987) and stops at the first
+     * cell that starts beyond the closest hit found so far.
+     * </p>
+     * <p>
+     * Primitives much larger than the typical one would fill most cells, so they are kept
+     * out of the grid in a short list of outliers that every ray tests first.
+     * </p>
+     */
+    class UniformGrid {
+    private:
+        Vector3 lo;
+        /**Edge lengths of a cell*/
+        Vector3 cellSize;
+        int res[3] = {0, 0, 0};
+        /**Offset of each cell's list in <b>ids</b>, plus the total at the end*/
+        vector<uint32_t> offsets;
+        vector<uint32_t> ids;
+        /**Primitives tested by every ray, in ascending order*/
+        vector<uint32_t> outliers;
+
+    public:
+        UniformGrid() {}
+
+        /**
+         * Builds a grid over the primitives of <b>store</b>.
+         */
+        UniformGrid(const PrimitiveStore &store, const GridSettings &settings = GridSettings());
+
+        /**
+         * Decides whether a grid is likely to beat testing every primitive: there must be
+         * enough primitives, and few enough outliers, since every ray tests those.
+         *
+         * @return <b>true</b> if <code>Accelerator::Auto</code> should build a grid for <b>store</b>
+         */
+        static bool suits(const PrimitiveStore &store, const GridSettings &settings = GridSettings());
+
+        /**
+         * @return <b>true</b> if this grid was built, i.e. is not default constructed
+         */
+        bool built() const {
+            return !offsets.empty();
+        }
+
+        /**
+         * Finds the closest intersection along a ray, like
+         * <code>PrimitiveStore::intersect</code>, whose store must be the one the grid was built from.
+         */
+        bool intersect(const PrimitiveStore &store, const Ray3 &ray, double tMax, Hit &hit) const;
+
+        /**
+         * @return the number of cells along each axis
+         */
+        int resolution(int axis) const {
+            return res[axis];
+        }
+
+        size_t outlierCount() const {
+            return outliers.size();
+        }
+
+        /**
+         * @return bytes used by the cell lists
+         */
+        size_t memoryUsage() const {
+            return (offsets.size() + ids.size() + outliers.size()) * sizeof(uint32_t);
+        }
+    };
+}
+#endif //RAYTRACER_C_UNIFORM_GRID_H
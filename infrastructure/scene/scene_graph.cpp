@@ -0,0 +1,217 @@
+/**
+* SceneNode and SceneGraph implementation
+*/
+
+#include "scene_graph.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace bla {
+    //========================
+    //=======SCENE NODE=======
+    //========================
+
+    SceneNode::SceneNode(SceneGraph *graph, SceneNode *parent)
+            : graph(graph), parent(parent), dirty(false), hasSphere(false), slot(-1), queuedMoved(false),
+              queuedNew(false) {
+        markDirty();
+    }
+
+    SceneNode *SceneNode::createChild() {
+        children.push_back(unique_ptr<SceneNode>(new SceneNode(graph, this)));
+        return children.back().get();
+    }
+
+    void SceneNode::setSphere(const Sphere &s, const Material &m) {
+        sphere = s;
+        material = m;
+        if (!hasSphere) {
+            hasSphere = true;
+            markDirty();
+        } else {
+            // Same node, new shape: the world transform is unchanged but the flattened sphere is not.
+            queueMoved();
+        }
+        queueNew();
+    }
+
+    void SceneNode::setMaterial(const Material &m) {
+        if (!hasSphere)
+            return;
+        material = m;
+        queueNew();
+    }
+
+    void SceneNode::queueMoved() {
+        if (!queuedMoved) {
+            queuedMoved = true;
+            graph->movedSpheres.push_back(this);
+        }
+    }
+
+    void SceneNode::queueNew() {
+        if (!queuedNew) {
+            queuedNew = true;
+            graph->newSpheres.push_back(this);
+        }
+    }
+
+    void SceneNode::markDirty() {
+        if (dirty)
+            return;
+
+        // Everything below a dirty node is dirty, so we can stop at nodes that already are.
+        if (parent == nullptr || !parent->dirty)
+            graph->dirtyRoots.push_back(this);
+
+        vector<SceneNode *> stack(1, this);
+        while (!stack.empty()) {
+            SceneNode *n = stack.back();
+            stack.pop_back();
+            n->dirty = true;
+            for (unique_ptr<SceneNode> &c : n->children) {
+                if (!c->dirty)
+                    stack.push_back(c.get());
+            }
+        }
+    }
+
+    void SceneNode::computeWorld() {
+        world = parent == nullptr ? local.getMatrix() : parent->world.getMult(local.getMatrix());
+        dirty = false;
+        if (hasSphere)
+            queueMoved();
+    }
+
+    void SceneNode::setLocal(const TRS &T) {
+        local = T;
+        markDirty();
+    }
+
+    const Matrix4 &SceneNode::getWorld() {
+        if (!dirty)
+            return world;
+
+        vector<SceneNode *> chain;
+        for (SceneNode *n = this; n != nullptr && n->dirty; n = n->parent)
+            chain.push_back(n);
+        for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+            (*it)->computeWorld();
+            // The dirty children of a node cleaned here now have a clean parent, so update() has to
+            // find them as dirty roots of their own.
+            for (unique_ptr<SceneNode> &c : (*it)->children) {
+                if (c->dirty)
+                    graph->dirtyRoots.push_back(c.get());
+            }
+        }
+
+        return world;
+    }
+
+    void SceneNode::translate(double x, double y, double z) {
+        local.translate(x, y, z);
+        markDirty();
+    }
+
+    void SceneNode::translate(Vector3 v) {
+        translate(v.x, v.y, v.z);
+    }
+
+    void SceneNode::rotX(double theta, bool aroundOrigin) {
+        local.rotX(theta, aroundOrigin);
+        markDirty();
+    }
+
+    void SceneNode::rotY(double theta, bool aroundOrigin) {
+        local.rotY(theta, aroundOrigin);
+        markDirty();
+    }
+
+    void SceneNode::rotZ(double theta, bool aroundOrigin) {
+        local.rotZ(theta, aroundOrigin);
+        markDirty();
+    }
+
+    void SceneNode::transform(Matrix4 M) {
+        transform(TRS::fromMatrix(M));
+    }
+
+    void SceneNode::transform(const TRS &T) {
+        local = T * local;
+        markDirty();
+    }
+
+    //=========================
+    //=======SCENE GRAPH=======
+    //=========================
+
+    SceneGraph::SceneGraph() : frame(0) {
+        root.reset(new SceneNode(this, nullptr));
+    }
+
+    size_t SceneGraph::updateSubtree(SceneNode *node) {
+        // Iterative so deep rigs cannot overflow the stack. Parents are popped before their children.
+        size_t computed = 0;
+        vector<SceneNode *> stack(1, node);
+        while (!stack.empty()) {
+            SceneNode *n = stack.back();
+            stack.pop_back();
+            n->computeWorld();
+            computed++;
+            for (unique_ptr<SceneNode> &c : n->children) {
+                if (c->dirty)
+                    stack.push_back(c.get());
+            }
+        }
+        return computed;
+    }
+
+    size_t SceneGraph::update() {
+        size_t computed = 0;
+
+        for (size_t i = 0; i < dirtyRoots.size(); i++) {
+            SceneNode *top = dirtyRoots[i];
+            if (!top->dirty)
+                continue;
+            // This node may have gotten a dirty ancestor after it was queued.
+            while (top->parent != nullptr && top->parent->dirty)
+                top = top->parent;
+
+            computed += updateSubtree(top);
+        }
+        dirtyRoots.clear();
+        frame++;
+
+        return computed;
+    }
+
+    size_t SceneGraph::flatten(Scene &scene) {
+        update();
+
+        // Brand new spheres get a slot at the end of the flattened arrays.
+        for (SceneNode *n : newSpheres) {
+            n->queuedNew = false;
+            if (n->slot < 0)
+                n->slot = scene.add(n->sphere, n->material);
+            else
+                scene.materials[n->slot] = n->material;
+        }
+
+        size_t written = 0;
+        for (SceneNode *n : movedSpheres) {
+            n->queuedMoved = false;
+            if (n->slot < 0 || n->dirty)
+                continue;
+            Sphere &s = scene.spheres[n->slot];
+            s.c = n->world.getTransformedVec(n->sphere.c);
+            s.r = n->sphere.r * n->world.getMaxScale();
+            written++;
+        }
+
+        newSpheres.clear();
+        movedSpheres.clear();
+        return written;
+    }
+}
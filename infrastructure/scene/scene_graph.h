@@ -0,0 +1,218 @@
+#ifndef RAYTRACER_C_SCENE_GRAPH_H
+#define RAYTRACER_C_SCENE_GRAPH_H
+
+#include "../math/mat4.h"
+#include "../math/sphere.h"
+#include "../math/transformable.h"
+#include "../render/scene.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using namespace std;
+namespace bla {
+    class SceneGraph;
+
+    /**
+     * A node in a <code>SceneGraph</code>. Every node has a local transform relative to its
+     * parent and may carry a sphere, given in the node's local space. Local transforms are
+     * kept as <code>TRS</code>, so long chains of changes to a node stay rigid. World
+     * transforms are the products of the baked local matrices, so a non-uniform scale above
+     * a rotated child places the child's spheres exactly where the matrices put them.
+     * <p>
+     * World transforms are computed lazily. Changing a node's local transform marks it and
+     * its subtree dirty (stopping at nodes that are already dirty, since their subtrees are
+     * too), and the world transform is only recomputed when someone asks for it or when the
+     * graph is updated for the next frame, at most once per change.
+     * </p>
+     */
+    class SceneNode : public Transformable {
+        friend class SceneGraph;
+
+    private:
+        SceneGraph *graph;
+        SceneNode *parent;
+        vector<unique_ptr<SceneNode>> children;
+
+        TRS local;
+        Matrix4 world;
+        bool dirty;
+
+        bool hasSphere;
+        Sphere sphere;
+        Material material;
+        /**Index of this node's sphere in the flattened <code>Scene</code>, or -1*/
+        int slot;
+        /**Whether this node is in the graph's <code>movedSpheres</code> and <code>newSpheres</code>*/
+        bool queuedMoved, queuedNew;
+
+        SceneNode(SceneGraph *graph, SceneNode *parent);
+
+        /**
+         * Marks this node and its subtree as needing a new world transform.
+         */
+        void markDirty();
+
+        /**
+         * Recomputes the world transform, assuming the parent's is up to date.
+         */
+        void computeWorld();
+
+        /**
+         * Queues this node's sphere to be rewritten by the next flatten, once.
+         */
+        void queueMoved();
+
+        /**
+         * Queues this node's sphere to be added or get its material by the next flatten, once.
+         */
+        void queueNew();
+
+    public:
+        /**
+         * Creates a new child of this node.
+         * @return the child; it is owned by this node
+         */
+        SceneNode *createChild();
+
+        /**
+         * Gives this node a sphere to carry.
+         *
+         * @param s the sphere in the node's local space
+         * @param m the sphere's material
+         */
+        void setSphere(const Sphere &s, const Material &m);
+
+        /**
+         * Changes the material of this node's sphere. Materials do not depend on the
+         * transform, so this does not dirty anything. Nodes without a sphere ignore it.
+         */
+        void setMaterial(const Material &m);
+
+        SceneNode *getParent() const {
+            return parent;
+        }
+
+        size_t childCount() const {
+            return children.size();
+        }
+
+        SceneNode *getChild(size_t i) const {
+            return children[i].get();
+        }
+
+        /**
+         * @return the transform relative to the parent node
+         */
+        const TRS &getLocal() const {
+            return local;
+        }
+
+        /**
+         * Replaces the transform relative to the parent node.
+         */
+        void setLocal(const TRS &T);
+
+        /**
+         * Replaces the transform relative to the parent node with the one <b>M</b> applies,
+         * see <code>TRS::fromMatrix</code>.
+         */
+        void setLocal(const Matrix4 &M) {
+            setLocal(TRS::fromMatrix(M));
+        }
+
+        /**
+         * @return the transform from this node's space to world space, recomputing it (and
+         * any dirty ancestors) first if needed
+         */
+        const Matrix4 &getWorld();
+
+        bool isDirty() const {
+            return dirty;
+        }
+
+        // Transformable, applied to the local transform.
+
+        void translate(double x, double y, double z);
+
+        void translate(Vector3 v);
+
+        void rotX(double theta, bool aroundOrigin);
+
+        void rotY(double theta, bool aroundOrigin);
+
+        void rotZ(double theta, bool aroundOrigin);
+
+        /**
+         * Applies <b>M</b> on top of the local transform, i.e. <code>L = M * L</code>, after
+         * decomposing it with <code>TRS::fromMatrix</code>.
+         */
+        void transform(Matrix4 M);
+
+        /**
+         * Applies <b>T</b> on top of the local transform, i.e. <code>L = T * L</code>, see
+         * <code>TRS::operator*</code>.
+         */
+        void transform(const TRS &T);
+    };
+
+    /**
+     * A transform hierarchy whose spheres are flattened into a <code>Scene</code> for the
+     * tracer. The graph remembers which subtrees changed, so a frame update only touches
+     * those subtrees and only rewrites the flattened spheres that actually moved.
+     */
+    class SceneGraph {
+        friend class SceneNode;
+
+    private:
+        unique_ptr<SceneNode> root;
+        /**Highest dirty nodes, i.e. dirty nodes with a clean parent, in the order they got dirty*/
+        vector<SceneNode *> dirtyRoots;
+        /**Spheres whose world transform changed since the last flatten, each once*/
+        vector<SceneNode *> movedSpheres;
+        /**Spheres that were added or had their material changed since the last flatten, each once*/
+        vector<SceneNode *> newSpheres;
+        uint64_t frame;
+
+        /**
+         * Recomputes the world transforms of a dirty node and its subtree.
+         * @return the number of nodes recomputed
+         */
+        size_t updateSubtree(SceneNode *node);
+
+    public:
+        SceneGraph();
+
+        /**
+         * @return the root node; its local transform is the world transform of the whole graph
+         */
+        SceneNode *getRoot() const {
+            return root.get();
+        }
+
+        /**
+         * Brings every world transform up to date. Only dirty subtrees are visited.
+         *
+         * @return the number of world transforms that were recomputed
+         */
+        size_t update();
+
+        /**
+         * Updates the graph and writes its spheres into <b>scene</b>. The first call fills
+         * <b>scene</b>; later calls only write the spheres that moved or were added since.
+         * <b>scene</b> must not be changed by anything else in between.
+         *
+         * @param scene the flattened scene for the tracer
+         * @return the number of spheres written
+         */
+        size_t flatten(Scene &scene);
+
+        /**
+         * @return how many times <code>update</code> has run
+         */
+        uint64_t getFrame() const {
+            return frame;
+        }
+    };
+}
+#endif //RAYTRACER_C_SCENE_GRAPH_H
@@ -0,0 +1,384 @@
+/**
+* RenderServer implementation
+*/
+
+#include "render_server.h"
+#include "../render/scene_io.h"
+#include "../render/trace.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace bla {
+    namespace {
+        /**Largest scene description LOAD accepts.*/
+        const size_t maxSceneBytes = 256u << 20;
+
+        /**
+         * Buffered, blocking reads and writes on a socket.
+         */
+        class Connection {
+        private:
+            int fd;
+            string buffer;
+
+            bool fill() {
+                char chunk[4096];
+                ssize_t n;
+                do {
+                    n = ::recv(fd, chunk, sizeof(chunk), 0);
+                } while (n < 0 && errno == EINTR);
+                if (n <= 0)
+                    return false;
+                buffer.append(chunk, (size_t) n);
+                return true;
+            }
+
+        public:
+            explicit Connection(int fd) : fd(fd) {}
+
+            bool readLine(string &line) {
+                size_t nl;
+                while ((nl = buffer.find('\n')) == string::npos) {
+                    if (!fill())
+                        return false;
+                }
+                line = buffer.substr(0, nl);
+                if (!line.empty() && line.back() == '\r')
+                    line.pop_back();
+                buffer.erase(0, nl + 1);
+                return true;
+            }
+
+            bool readExact(size_t n, string &out) {
+                while (buffer.size() < n) {
+                    if (!fill())
+                        return false;
+                }
+                out = buffer.substr(0, n);
+                buffer.erase(0, n);
+                return true;
+            }
+        };
+
+        bool writeAll(int fd, const void *data, size_t len) {
+            const char *p = (const char *) data;
+            while (len > 0) {
+                ssize_t n = ::send(fd, p, len, MSG_NOSIGNAL);
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n <= 0)
+                    return false;
+                p += n;
+                len -= (size_t) n;
+            }
+            return true;
+        }
+
+        bool writeLine(int fd, const string &line) {
+            string s = line + "\n";
+            return writeAll(fd, s.data(), s.size());
+        }
+
+        bool parseVector(const string &s, Vector3 &v) {
+            char extra;
+            return sscanf(s.c_str(), "%lf,%lf,%lf%c", &v.x, &v.y, &v.z, &extra) == 3;
+        }
+
+        string hex(uint64_t h) {
+            char buf[17];
+            snprintf(buf, sizeof(buf), "%016llx", (unsigned long long) h);
+            return buf;
+        }
+    }
+
+    //===================
+    //=======CACHE=======
+    //===================
+
+    bool SceneCache::load(const string &text, uint64_t &hash, string &error) {
+        hash = hashScene(text);
+        {
+            lock_guard<mutex> guard(lock);
+            auto it = entries.find(hash);
+            if (it != entries.end()) {
+                it->second.lastUse = ++clock;
+                return true;
+            }
+        }
+
+        // Parse and index outside the lock so other clients are not held up by a big scene.
+        Scene scene;
+        if (!parseScene(text, scene, error))
+            return false;
+        shared_ptr<const Resident> resident = make_shared<Resident>(move(scene));
+
+        lock_guard<mutex> guard(lock);
+        while (entries.size() >= capacity) {
+            auto oldest = entries.begin();
+            for (auto it = entries.begin(); it != entries.end(); ++it) {
+                if (it->second.lastUse < oldest->second.lastUse)
+                    oldest = it;
+            }
+            entries.erase(oldest);
+        }
+        entries[hash] = Entry{resident, ++clock};
+        return true;
+    }
+
+    shared_ptr<const PreparedScene> SceneCache::get(uint64_t hash) {
+        lock_guard<mutex> guard(lock);
+        auto it = entries.find(hash);
+        if (it == entries.end())
+            return nullptr;
+        it->second.lastUse = ++clock;
+        // Share ownership of the whole entry so the Scene outlives the PreparedScene that references it.
+        const shared_ptr<const Resident> &resident = it->second.resident;
+        return shared_ptr<const PreparedScene>(resident, &resident->prepared);
+    }
+
+    size_t SceneCache::size() {
+        lock_guard<mutex> guard(lock);
+        return entries.size();
+    }
+
+    //====================
+    //=======SERVER=======
+    //====================
+
+    RenderServer::RenderServer(const ServerSettings &settings)
+            : settings(settings), cache(settings.maxScenes), running(false) {}
+
+    RenderServer::~RenderServer() {
+        stop();
+        for (thread &t : workers)
+            t.join();
+    }
+
+    bool RenderServer::run(string &error) {
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (settings.socketPath.size() >= sizeof(addr.sun_path)) {
+            error = "socket path is too long";
+            return false;
+        }
+        strcpy(addr.sun_path, settings.socketPath.c_str());
+
+        listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listenFd < 0) {
+            error = string("socket: ") + strerror(errno);
+            return false;
+        }
+        ::unlink(settings.socketPath.c_str());
+        if (::bind(listenFd, (sockaddr *) &addr, sizeof(addr)) < 0 || ::listen(listenFd, 16) < 0) {
+            error = settings.socketPath + ": " + strerror(errno);
+            ::close(listenFd);
+            listenFd = -1;
+            return false;
+        }
+
+        running = true;
+        while (running) {
+            int fd = ::accept(listenFd, nullptr, nullptr);
+            if (fd < 0) {
+                if (errno == EINTR)
+                    continue;
+                break;
+            }
+            lock_guard<mutex> guard(clientsLock);
+            if (!running) {
+                ::close(fd);
+                break;
+            }
+            reapWorkers();
+            clients.insert(fd);
+            workers.emplace_back(&RenderServer::serveClient, this, fd);
+        }
+
+        stop();
+        for (thread &t : workers)
+            t.join();
+        workers.clear();
+        finishedWorkers.clear();
+        ::close(listenFd);
+        listenFd = -1;
+        ::unlink(settings.socketPath.c_str());
+        return true;
+    }
+
+    void RenderServer::stop() {
+        running = false;
+        if (listenFd >= 0)
+            ::shutdown(listenFd, SHUT_RDWR);
+
+        // Wake up clients blocked in recv so their threads can finish.
+        lock_guard<mutex> guard(clientsLock);
+        for (int fd : clients)
+            ::shutdown(fd, SHUT_RDWR);
+    }
+
+    void RenderServer::reapWorkers() {
+        for (thread::id id : finishedWorkers) {
+            for (auto it = workers.begin(); it != workers.end(); ++it) {
+                if (it->get_id() == id) {
+                    // The worker is past its last use of the server and only has to return.
+                    it->join();
+                    workers.erase(it);
+                    break;
+                }
+            }
+        }
+        finishedWorkers.clear();
+    }
+
+    void RenderServer::serveClient(int fd) {
+        Connection conn(fd);
+        string line;
+
+        while (running && conn.readLine(line)) {
+            string cmd = line.substr(0, line.find(' '));
+            string args = cmd.size() < line.size() ? line.substr(cmd.size() + 1) : "";
+            bool ok = true;
+
+            if (cmd == "LOAD") {
+                char *end;
+                unsigned long long n = strtoull(args.c_str(), &end, 10);
+                string text;
+                if (args.empty() || *end != '\0' || n > maxSceneBytes) {
+                    // We cannot tell where the scene data ends, so the connection is unusable.
+                    writeLine(fd, "ERR LOAD expects the size of the scene in bytes");
+                    ok = false;
+                } else if (!conn.readExact((size_t) n, text)) {
+                    break;
+                } else {
+                    ok = handleLoad(fd, text);
+                }
+            } else if (cmd == "RENDER") {
+                ok = handleRender(fd, args);
+            } else if (cmd == "QUIT") {
+                break;
+            } else if (cmd == "SHUTDOWN") {
+                writeLine(fd, "OK");
+                stop();
+                break;
+            } else {
+                ok = writeLine(fd, "ERR unknown command '" + cmd + "'");
+            }
+
+            if (!ok)
+                break;
+        }
+
+        lock_guard<mutex> guard(clientsLock);
+        clients.erase(fd);
+        ::close(fd);
+        finishedWorkers.push_back(this_thread::get_id());
+    }
+
+    bool RenderServer::handleLoad(int fd, const string &text) {
+        uint64_t hash;
+        string error;
+        if (!cache.load(text, hash, error))
+            return writeLine(fd, "ERR " + error);
+        return writeLine(fd, "OK " + hex(hash));
+    }
+
+    bool RenderServer::handleRender(int fd, const string &args) {
+        RenderSettings rs;
+        rs.threads = settings.threads;
+        Camera camera(Vector3(0.0, 0.0, -5.0), VEC_ZERO, VEC_J, 45.0);
+        shared_ptr<const PreparedScene> scene;
+
+        istringstream in(args);
+        string token;
+        while (in >> token) {
+            size_t eq = token.find('=');
+            string key = token.substr(0, eq);
+            string value = eq == string::npos ? "" : token.substr(eq + 1);
+            bool valid = true;
+
+            if (key == "scene") {
+                scene = cache.get(strtoull(value.c_str(), nullptr, 16));
+                if (!scene)
+                    return writeLine(fd, "ERR scene " + value + " is not loaded");
+            } else if (key == "eye") {
+                valid = parseVector(value, camera.eye);
+            } else if (key == "target") {
+                valid = parseVector(value, camera.target);
+            } else if (key == "up") {
+                valid = parseVector(value, camera.up);
+            } else if (key == "fov") {
+                camera.fov = atof(value.c_str());
+            } else if (key == "width") {
+                rs.width = atoi(value.c_str());
+            } else if (key == "height") {
+                rs.height = atoi(value.c_str());
+            } else if (key == "spp") {
+                rs.spp = atoi(value.c_str());
+            } else if (key == "depth") {
+                rs.maxDepth = atoi(value.c_str());
+            } else if (key == "seed") {
+                rs.seed = strtoull(value.c_str(), nullptr, 10);
+            } else if (key == "region") {
+                valid = sscanf(value.c_str(), "%d,%d,%d,%d", &rs.region.x0, &rs.region.y0,
+                               &rs.region.x1, &rs.region.y1) == 4;
+            } else {
+                valid = false;
+            }
+
+            if (!valid)
+                return writeLine(fd, "ERR bad argument '" + token + "'");
+        }
+
+        if (!scene)
+            return writeLine(fd, "ERR RENDER needs scene=<key>");
+        if (rs.width <= 0 || rs.height <= 0 || rs.spp <= 0 || rs.width > 16384 || rs.height > 16384)
+            return writeLine(fd, "ERR bad resolution or sample count");
+        // A negative depth never ends a path, and the job would hold renderLock forever.
+        if (rs.maxDepth < 0 || rs.maxDepth > RenderSettings::MAX_DEPTH)
+            return writeLine(fd, "ERR depth must be in [0, " + to_string(RenderSettings::MAX_DEPTH) + "]");
+        if (!(camera.fov > 0.0 && camera.fov < 180.0))
+            return writeLine(fd, "ERR fov must be in (0, 180)");
+        camera.aspect = (double) rs.width / rs.height;
+
+        lock_guard<mutex> job(renderLock);
+        mutex writeLock;
+        bool connected = true;
+        // Set once a write fails, so the workers stop rendering for a client that is gone.
+        atomic<bool> disconnected(false);
+        rs.stop = &disconnected;
+        FrameBuffer fb;
+
+        Renderer::render(*scene, camera, rs, fb, [&](const Tile &tile) {
+            vector<float> data;
+            data.reserve((size_t) tile.width() * tile.height() * 3);
+            for (int y = tile.y0; y < tile.y1; y++) {
+                for (int x = tile.x0; x < tile.x1; x++) {
+                    const Vector3 &c = fb.color[fb.index(x, y)];
+                    data.push_back((float) c.x);
+                    data.push_back((float) c.y);
+                    data.push_back((float) c.z);
+                }
+            }
+
+            TraceSpan span("send tile", "io", tile.index);
+            lock_guard<mutex> guard(writeLock);
+            if (!connected)
+                return;
+            char header[64];
+            snprintf(header, sizeof(header), "TILE %d %d %d %d", tile.x0, tile.y0, tile.x1, tile.y1);
+            connected = writeLine(fd, header) && writeAll(fd, data.data(), data.size() * sizeof(float));
+            if (!connected)
+                disconnected = true;
+        });
+
+        return connected && writeLine(fd, "DONE");
+    }
+}
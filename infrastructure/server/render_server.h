@@ -0,0 +1,149 @@
+#ifndef RAYTRACER_C_RENDER_SERVER_H
+#define RAYTRACER_C_RENDER_SERVER_H
+
+#include "../render/renderer.h"
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+namespace bla {
+    /**
+     * Options for the <code>RenderServer</code>.
+     */
+    struct ServerSettings {
+        /**Path of the Unix domain socket to listen on*/
+        string socketPath = "/tmp/raytracer.sock";
+        /**How many scenes to keep resident; the least recently used one is dropped first*/
+        size_t maxScenes = 16;
+        /**Worker threads per render job, or 0 for one per hardware thread*/
+        int threads = 0;
+    };
+
+    /**
+     * Keeps parsed scenes in memory, keyed by the hash of their description.
+     * All methods are thread safe.
+     */
+    class SceneCache {
+    private:
+        /**
+         * A scene and the structures built for it, kept together so they share a lifetime. The
+         * spheres are dropped once packed, so a resident scene holds its geometry only once.
+         */
+        struct Resident {
+            Scene scene;
+            PreparedScene prepared;
+
+            explicit Resident(Scene &&s) : scene(move(s)), prepared(scene) {
+                vector<Sphere>().swap(scene.spheres);
+            }
+        };
+
+        struct Entry {
+            shared_ptr<const Resident> resident;
+            uint64_t lastUse;
+        };
+
+        mutex lock;
+        map<uint64_t, Entry> entries;
+        uint64_t clock = 0;
+        size_t capacity;
+
+    public:
+        explicit SceneCache(size_t capacity) : capacity(capacity > 0 ? capacity : 1) {}
+
+        /**
+         * Parses, prepares and stores a scene, unless a scene with the same description is already resident.
+         *
+         * @param text the scene description
+         * @param hash receives the key of the scene
+         * @param error receives the parse error on failure
+         * @return <b>true</b> on success
+         */
+        bool load(const string &text, uint64_t &hash, string &error);
+
+        /**
+         * @return the prepared scene stored under <b>hash</b>, or <code>nullptr</code>. The
+         * returned pointer keeps the underlying <code>Scene</code> alive as well
+         */
+        shared_ptr<const PreparedScene> get(uint64_t hash);
+
+        size_t size();
+    };
+
+    /**
+     * A long running render process. Clients connect to a Unix domain socket and send
+     * newline terminated commands:
+     *
+     * <pre>
+     * LOAD &lt;bytes&gt;            followed by &lt;bytes&gt; of scene description
+     *                         -> OK &lt;scene&gt;            (scene key, 16 hex digits)
+     * RENDER scene=&lt;key&gt; [eye=x,y,z] [target=x,y,z] [up=x,y,z] [fov=deg] [width=w] [height=h]
+     *        [spp=n] [depth=n] [seed=n] [region=x0,y0,x1,y1]
+     *                         -> TILE x0 y0 x1 y1       one per finished tile, followed by
+     *                                                   (x1-x0)*(y1-y0) RGB triples of host
+     *                                                   order 32 bit floats, row major
+     *                         -> DONE
+     * QUIT                    closes the connection
+     * SHUTDOWN                stops the server
+     * </pre>
+     *
+     * Failed commands answer <code>ERR &lt;message&gt;</code>; RENDER fails unless
+     * 0 &lt; fov &lt; 180 and 0 &lt;= depth &lt;= <code>RenderSettings::MAX_DEPTH</code>. Scenes stay loaded between jobs,
+     * so sending many camera or sampling variations of one scene only pays for the scene
+     * setup once. Render jobs run one at a time, each using all worker threads. A job whose
+     * client disconnects stops at the next tile.
+     */
+    class RenderServer {
+    private:
+        ServerSettings settings;
+        SceneCache cache;
+        mutex renderLock;
+
+        int listenFd = -1;
+        atomic<bool> running;
+        mutex clientsLock;
+        set<int> clients;
+        list<thread> workers;
+        /**Workers whose client is gone, to be joined by the accepting thread*/
+        vector<thread::id> finishedWorkers;
+
+        void serveClient(int fd);
+
+        /**
+         * Joins the workers in <b>finishedWorkers</b>, so a long running server does not keep
+         * the stacks of every client it ever had. Call with <b>clientsLock</b> held.
+         */
+        void reapWorkers();
+
+        bool handleLoad(int fd, const string &text);
+
+        bool handleRender(int fd, const string &args);
+
+    public:
+        explicit RenderServer(const ServerSettings &settings);
+
+        ~RenderServer();
+
+        /**
+         * Listens for clients until a <code>SHUTDOWN</code> command arrives or <code>stop</code> is called.
+         *
+         * @param error receives a description of the problem if the socket could not be set up
+         * @return <b>true</b> if the server ran and shut down cleanly
+         */
+        bool run(string &error);
+
+        /**
+         * Makes <code>run</code> return. Safe to call from any thread.
+         */
+        void stop();
+    };
+}
+#endif //RAYTRACER_C_RENDER_SERVER_H
@@ -1,19 +1,274 @@
+#include <atomic>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <string>
 #include "./infrastructure/math/vec3.h"
 #include "./infrastructure/math/mat4.h"
+#include "./infrastructure/render/checkpoint.h"
+#include "./infrastructure/render/denoiser.h"
+#include "./infrastructure/render/image.h"
+#include "./infrastructure/render/renderer.h"
+#include "./infrastructure/render/scene_io.h"
+#include "./infrastructure/render/temporal.h"
+#include "./infrastructure/render/trace.h"
+#include "./infrastructure/server/render_server.h"
 
 using namespace std;
 using namespace bla;
 
-int main() {
-    // Matrix4* A = Matrix4::getTranslationInstance(1, 2, 3);
-    //A->rotY(1.5, true);
-    //A->translate(Vector3(2.0, 2.0, 2.0));
-    //cout << A->toString() << endl;
-    //cout << Matrix4::getRotYInstance(3.0).toString() << endl;
-    double l[] = {1, 2, 3};
-    Vector3 v = Vector3();
-    cout << v.toString() << endl;
+/**
+ * A few diffuse spheres on a ground plane, lit by one spherical light and a dim sky.
+ */
+static Scene buildDemoScene() {
+    TraceSpan span("demo scene", "scene");
+    Scene scene;
+    scene.background = Vector3(0.05, 0.06, 0.08);
+
+    scene.add(Sphere(Vector3(0.0, -1000.0, 0.0), 1000.0), Material(Vector3(0.7, 0.7, 0.7)));
+    scene.add(Sphere(Vector3(-1.2, 0.6, 0.0), 0.6), Material(Vector3(0.8, 0.25, 0.2)));
+    scene.add(Sphere(Vector3(0.0, 0.8, 0.4), 0.8), Material(Vector3(0.2, 0.6, 0.8)));
+    scene.add(Sphere(Vector3(1.3, 0.5, -0.3), 0.5), Material(Vector3(0.9, 0.9, 0.3)));
+    scene.add(Sphere(Vector3(0.5, 4.0, -1.5), 1.0), Material(VEC_ZERO, Vector3(8.0, 7.5, 7.0)));
+
+    return scene;
+}
+
+/**
+ * @return <b>path</b> with the frame number inserted before the extension
+ */
+static string framePath(const string &path, int frame) {
+    char number[16];
+    snprintf(number, sizeof(number), "_%04d", frame);
+    size_t dot = path.rfind('.');
+    return dot == string::npos ? path + number : path.substr(0, dot) + number + path.substr(dot);
+}
+
+/**
+ * Renders a turntable: the camera circles the target around the vertical axis, reusing
+ * samples from one frame to the next.
+ */
+static int renderTurntable(const Scene &scene, const Camera &start, const RenderSettings &settings, int frames,
+                           double degreesPerFrame, bool denoise, const string &outPath) {
+    PreparedScene prepared(scene, settings.accelerator, settings.threads);
+    TemporalRenderer renderer(settings);
+    Vector3 offset = start.eye - start.target;
+
+    for (int f = 0; f < frames; f++) {
+        double a = f * degreesPerFrame * M_PI / 180.0;
+        Camera camera = start;
+        camera.eye = start.target + Vector3(offset.x * cos(a) - offset.z * sin(a), offset.y,
+                                            offset.x * sin(a) + offset.z * cos(a));
+
+        FrameBuffer fb;
+        TemporalStats stats = renderer.renderFrame(prepared, camera, nullptr, fb);
+        if (denoise)
+            Denoiser::denoise(fb, DenoiseSettings());
+
+        string path = framePath(outPath, f);
+        if (!writePPM(path, fb.color, fb.width, fb.height)) {
+            cerr << "could not write " << path << endl;
+            return 1;
+        }
+        cout << path << ": " << stats.render.rays << " rays, " << stats.traced << " of "
+             << stats.traced + stats.reused << " pixels traced" << endl;
+    }
+    return 0;
+}
+
+static atomic<bool> stopRequested(false);
+
+static void requestStop(int) {
+    stopRequested = true;
+}
+
+/**
+ * Renders one image while saving its progress to <b>checkpointPath</b>, picking up where
+ * an earlier, interrupted run with the same arguments left off. <code>SIGTERM</code> and
+ * <code>SIGINT</code> save the progress and exit; the checkpoint is deleted once the image
+ * is written.
+ */
+static int renderCheckpointed(const Scene &scene, const Camera &camera, const RenderSettings &settings,
+                              const CheckpointSettings &checkpoint, const string &checkpointPath, bool denoise,
+                              const string &outPath) {
+    signal(SIGTERM, requestStop);
+    signal(SIGINT, requestStop);
+    CheckpointSettings cs = checkpoint;
+    cs.stop = &stopRequested;
+
+    FrameBuffer fb;
+    CheckpointStats stats;
+    string error;
+    PreparedScene prepared(scene, settings.accelerator, settings.threads);
+    if (!CheckpointRenderer::render(prepared, camera, settings, checkpointPath, cs, fb, stats, error)) {
+        cerr << error << endl;
+        return 1;
+    }
+    if (stats.resumed)
+        cout << "resumed " << stats.resumedSamples << " pixel samples from " << checkpointPath << endl;
+    if (!stats.finished) {
+        cout << "stopped; progress saved to " << checkpointPath << endl;
+        return 2;
+    }
+
+    if (denoise)
+        Denoiser::denoise(fb, DenoiseSettings());
+    if (!writePPM(outPath, fb.color, fb.width, fb.height)) {
+        cerr << "could not write " << outPath << endl;
+        return 1;
+    }
+    remove(checkpointPath.c_str());
+    return 0;
+}
+
+/**
+ * Writes the recorded timeline to <b>path</b>, if any, when it goes out of scope, so that
+ * every way out of <code>main</code> leaves a trace behind.
+ */
+struct TraceDump {
+    string path;
+
+    ~TraceDump() {
+        if (path.empty())
+            return;
+        Trace::stop();
+        string error;
+        if (!Trace::write(path, error))
+            cerr << error << endl;
+    }
+};
+
+static void usage() {
+    cerr << "usage: Raytracer_C__ [--scene FILE] [--width N] [--height N] [--spp N] [--depth N] [--threads N]\n"
+            "                     [--seed N] [--denoise] [--out FILE.ppm] [--frames N [--orbit DEGREES]]\n"
+            "                     [--checkpoint FILE [--checkpoint-interval SECONDS]] [--accel auto|none|grid]\n"
+            "                     [--trace FILE.json]\n"
+            "       Raytracer_C__ --serve SOCKET [--max-scenes N] [--threads N]" << endl;
+}
+
+int main(int argc, char **argv) {
+    RenderSettings settings;
+    bool denoise = false;
+    string outPath = "render.ppm";
+    string scenePath;
+    string socketPath;
+    ServerSettings server;
+    int frames = 1;
+    double orbit = 2.0;
+    string checkpointPath;
+    CheckpointSettings checkpoint;
+    string tracePath;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--denoise") {
+            denoise = true;
+        } else if (arg == "--width" && hasValue) {
+            settings.width = atoi(argv[++i]);
+        } else if (arg == "--height" && hasValue) {
+            settings.height = atoi(argv[++i]);
+        } else if (arg == "--spp" && hasValue) {
+            settings.spp = atoi(argv[++i]);
+        } else if (arg == "--depth" && hasValue) {
+            settings.maxDepth = atoi(argv[++i]);
+        } else if (arg == "--threads" && hasValue) {
+            settings.threads = atoi(argv[++i]);
+        } else if (arg == "--seed" && hasValue) {
+            settings.seed = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--out" && hasValue) {
+            outPath = argv[++i];
+        } else if (arg == "--scene" && hasValue) {
+            scenePath = argv[++i];
+        } else if (arg == "--serve" && hasValue) {
+            socketPath = argv[++i];
+        } else if (arg == "--frames" && hasValue) {
+            frames = atoi(argv[++i]);
+        } else if (arg == "--orbit" && hasValue) {
+            orbit = atof(argv[++i]);
+        } else if (arg == "--checkpoint" && hasValue) {
+            checkpointPath = argv[++i];
+        } else if (arg == "--checkpoint-interval" && hasValue) {
+            checkpoint.interval = atof(argv[++i]);
+        } else if (arg == "--accel" && hasValue) {
+            string accel = argv[++i];
+            if (accel == "auto") {
+                settings.accelerator = Accelerator::Auto;
+            } else if (accel == "none") {
+                settings.accelerator = Accelerator::None;
+            } else if (accel == "grid") {
+                settings.accelerator = Accelerator::Grid;
+            } else {
+                usage();
+                return 1;
+            }
+        } else if (arg == "--trace" && hasValue) {
+            tracePath = argv[++i];
+        } else if (arg == "--max-scenes" && hasValue) {
+            server.maxScenes = (size_t) atoi(argv[++i]);
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    // Like the server's request parser: zero or negative sizes would divide by zero further down.
+    if (settings.width <= 0 || settings.height <= 0 || settings.width > 16384 || settings.height > 16384 ||
+        settings.spp <= 0 || settings.maxDepth < 0 || settings.maxDepth > RenderSettings::MAX_DEPTH || frames <= 0) {
+        cerr << "bad resolution, sample count, depth or frame count" << endl;
+        usage();
+        return 1;
+    }
+
+    TraceDump traceDump{tracePath};
+    if (!tracePath.empty())
+        Trace::start();
+
+    if (!socketPath.empty()) {
+        server.socketPath = socketPath;
+        server.threads = settings.threads;
+        RenderServer rs(server);
+        string error;
+        if (!rs.run(error)) {
+            cerr << error << endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    Scene scene = buildDemoScene();
+    if (!scenePath.empty()) {
+        string text, error;
+        if (!readTextFile(scenePath, text)) {
+            cerr << "could not read " << scenePath << endl;
+            return 1;
+        }
+        if (!parseScene(text, scene, error)) {
+            cerr << scenePath << ": " << error << endl;
+            return 1;
+        }
+    }
+    Camera camera(Vector3(0.0, 1.5, -6.0), Vector3(0.0, 0.7, 0.0), VEC_J, 40.0,
+                  (double) settings.width / settings.height);
+
+    if (frames > 1)
+        return renderTurntable(scene, camera, settings, frames, orbit, denoise, outPath);
+    if (!checkpointPath.empty())
+        return renderCheckpointed(scene, camera, settings, checkpoint, checkpointPath, denoise, outPath);
+
+    FrameBuffer fb;
+    Renderer::render(scene, camera, settings, fb);
+    if (denoise)
+        Denoiser::denoise(fb, DenoiseSettings());
+
+    if (!writePPM(outPath, fb.color, fb.width, fb.height)) {
+        cerr << "could not write " << outPath << endl;
+        return 1;
+    }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,48 @@
+/**
+* What the tests in this directory share: each prints one line per check and exits with
+* <code>checkResult()</code>, so CTest fails the test if any check did.
+*/
+#ifndef RAYTRACER_C_TESTS_CHECK_H
+#define RAYTRACER_C_TESTS_CHECK_H
+
+#include <iostream>
+#include <string>
+#include "../infrastructure/render/framebuffer.h"
+
+using namespace std;
+namespace bla {
+    inline bool &checkFailed() {
+        static bool failed = false;
+        return failed;
+    }
+
+    /**
+     * Prints <b>what</b> as passed or failed, and remembers a failure.
+     */
+    inline void check(bool ok, const string &what) {
+        cout << (ok ? "ok:   " : "FAIL: ") << what << endl;
+        checkFailed() |= !ok;
+    }
+
+    /**
+     * @return the exit code of a test: 1 if any check failed
+     */
+    inline int checkResult() {
+        return checkFailed() ? 1 : 0;
+    }
+
+    /**
+     * @return <b>true</b> if both frames have the same size and bit-identical color and AOVs
+     */
+    inline bool sameImage(const FrameBuffer &a, const FrameBuffer &b) {
+        if (a.size() != b.size())
+            return false;
+        for (size_t i = 0; i < a.size(); i++) {
+            if (!(a.color[i] == b.color[i]) || !(a.albedo[i] == b.albedo[i]) || !(a.emission[i] == b.emission[i]) ||
+                !(a.normal[i] == b.normal[i]) || a.depth[i] != b.depth[i] || a.variance[i] != b.variance[i])
+                return false;
+        }
+        return true;
+    }
+}
+#endif //RAYTRACER_C_TESTS_CHECK_H
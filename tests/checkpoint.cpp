@@ -0,0 +1,88 @@
+/**
+* Checks that a checkpointed render killed part way through resumes to exactly the image an
+* uninterrupted render produces, that a finished checkpoint traces nothing more, and that a
+* checkpoint is not resumed for a different scene.
+*/
+
+#include <csignal>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "../infrastructure/render/checkpoint.h"
+#include "../infrastructure/render/scene_io.h"
+#include "check.h"
+
+using namespace std;
+using namespace bla;
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        cerr << "usage: bla_checkpoint SCENE CHECKPOINT" << endl;
+        return 1;
+    }
+    string path = argv[2];
+    remove(path.c_str());
+
+    Scene scene;
+    string text, error;
+    if (!readTextFile(argv[1], text) || !parseScene(text, scene, error)) {
+        cerr << argv[1] << ": " << (error.empty() ? "could not read" : error) << endl;
+        return 1;
+    }
+
+    RenderSettings settings;
+    settings.width = 96;
+    settings.height = 72;
+    settings.spp = 96;
+    settings.threads = 2;
+    Camera camera(Vector3(0.0, 1.5, -6.0), Vector3(0.0, 0.7, 0.0), VEC_J, 40.0,
+                  (double) settings.width / settings.height);
+    PreparedScene prepared(scene);
+    CheckpointSettings checkpoint;
+    checkpoint.interval = 0.0;
+    checkpoint.passSamples = 3;
+
+    FrameBuffer reference;
+    Renderer::render(prepared, camera, settings, reference);
+
+    // Pre-empt a render without warning, once it has saved some progress.
+    pid_t child = fork();
+    if (child == 0) {
+        FrameBuffer fb;
+        CheckpointStats stats;
+        CheckpointRenderer::render(prepared, camera, settings, path, checkpoint, fb, stats, error);
+        _exit(0);
+    }
+    struct stat st;
+    while (stat(path.c_str(), &st) != 0)
+        usleep(1000);
+    usleep(100000);
+    kill(child, SIGKILL);
+    waitpid(child, nullptr, 0);
+
+    FrameBuffer resumed;
+    CheckpointStats stats;
+    bool ok = CheckpointRenderer::render(prepared, camera, settings, path, checkpoint, resumed, stats, error);
+    check(ok, ok ? "resumed the killed render" : error);
+    uint64_t total = (uint64_t) settings.width * settings.height * settings.spp;
+    cout << "      resumed " << stats.resumedSamples << " of " << total << " pixel samples, saved "
+         << stats.tilesWritten << " tiles in " << stats.checkpoints << " checkpoints" << endl;
+    check(stats.resumed && stats.resumedSamples > 0 && stats.resumedSamples < total,
+          "the killed render left partial progress");
+    check(stats.finished && sameImage(resumed, reference), "resumed render matches an uninterrupted one");
+
+    FrameBuffer again;
+    check(CheckpointRenderer::render(prepared, camera, settings, path, checkpoint, again, stats, error) &&
+          stats.render.rays == 0 && stats.resumedSamples == total && sameImage(again, reference),
+          "a finished checkpoint traces nothing");
+
+    scene.materials[1].albedo = Vector3(0.1, 0.9, 0.1);
+    ok = CheckpointRenderer::render(PreparedScene(scene), camera, settings, path, checkpoint, again, stats, error);
+    check(!ok, "a changed scene is refused (" + error + ")");
+
+    remove(path.c_str());
+    return checkResult();
+}
@@ -0,0 +1,62 @@
+/**
+* Checks that the denoiser keeps directly visible emitters, whose albedo is zero, at their
+* radiance instead of demodulating them to black, and that it leaves no NaN behind.
+*/
+
+#include <cmath>
+#include <iostream>
+#include <string>
+#include "../infrastructure/render/denoiser.h"
+#include "../infrastructure/render/renderer.h"
+#include "../infrastructure/render/scene_io.h"
+#include "check.h"
+
+using namespace std;
+using namespace bla;
+
+static bool finite(const Vector3 &v) {
+    return isfinite(v.x) && isfinite(v.y) && isfinite(v.z);
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        cerr << "usage: bla_denoiser SCENE" << endl;
+        return 1;
+    }
+    Scene scene;
+    string text, error;
+    if (!readTextFile(argv[1], text) || !parseScene(text, scene, error)) {
+        cerr << argv[1] << ": " << (error.empty() ? "could not read" : error) << endl;
+        return 1;
+    }
+
+    RenderSettings settings;
+    settings.width = 64;
+    settings.height = 48;
+    settings.spp = 4;
+    // Looks up at the light so that it covers a good part of the frame.
+    Camera camera(Vector3(0.0, 1.5, -6.0), Vector3(0.5, 3.0, -1.5), VEC_J, 40.0,
+                  (double) settings.width / settings.height);
+    FrameBuffer fb;
+    Renderer::render(scene, camera, settings, fb);
+
+    vector<Vector3> out;
+    Denoiser::denoise(fb, DenoiseSettings(), out);
+
+    size_t lightPixels = 0, keptLightPixels = 0;
+    bool allFinite = true;
+    for (size_t i = 0; i < fb.size(); i++) {
+        allFinite &= finite(out[i]);
+        // Every sample of the pixel hit the light: nothing but emission to filter.
+        if (fb.albedo[i] == VEC_ZERO && fb.emission[i].x > 1.0) {
+            lightPixels++;
+            keptLightPixels += fabs(out[i].x - fb.color[i].x) < 1e-6 && fabs(out[i].y - fb.color[i].y) < 1e-6 &&
+                               fabs(out[i].z - fb.color[i].z) < 1e-6;
+        }
+    }
+    cout << "      " << lightPixels << " pixels see only the light" << endl;
+    check(lightPixels > 0, "the light is in view");
+    check(keptLightPixels == lightPixels, "pixels that see only the light keep its radiance");
+    check(allFinite, "the denoised frame has no NaN or infinite pixels");
+    return checkResult();
+}
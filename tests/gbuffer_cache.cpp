@@ -0,0 +1,81 @@
+/**
+* Checks that renders through a GBufferCache match renders without one, that material and
+* light changes and renders of other scenes reuse the cached first hits, and that camera
+* and geometry changes do not, however the geometry was changed.
+*/
+
+#include <iostream>
+#include <string>
+#include "../infrastructure/render/renderer.h"
+#include "../infrastructure/render/scene_io.h"
+#include "check.h"
+
+using namespace std;
+using namespace bla;
+
+/**
+ * Renders through the cache and from scratch, and checks that both agree.
+ *
+ * @return whether the cached render reused the first hits
+ */
+static bool renderBoth(const Scene &scene, const Camera &camera, const RenderSettings &settings,
+                       GBufferCache &cache, const string &what) {
+    PreparedScene prepared(scene);
+    FrameBuffer cached, fresh;
+    RenderStats stats = Renderer::render(prepared, camera, settings, cached, cache);
+    Renderer::render(prepared, camera, settings, fresh);
+    check(sameImage(cached, fresh), what + ": cached render matches a full render");
+    return stats.reusedPrimary;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        cerr << "usage: bla_gbuffer_cache SCENE" << endl;
+        return 1;
+    }
+
+    Scene scene;
+    string text, error;
+    if (!readTextFile(argv[1], text) || !parseScene(text, scene, error)) {
+        cerr << argv[1] << ": " << (error.empty() ? "could not read" : error) << endl;
+        return 1;
+    }
+
+    RenderSettings settings;
+    settings.width = 64;
+    settings.height = 48;
+    settings.spp = 4;
+    Camera camera(Vector3(0.0, 1.5, -6.0), Vector3(0.0, 0.7, 0.0), VEC_J, 40.0,
+                  (double) settings.width / settings.height);
+    GBufferCache cache;
+
+    check(!renderBoth(scene, camera, settings, cache, "first render"), "first render traces primary rays");
+
+    scene.materials[1].albedo = Vector3(0.1, 0.9, 0.1);
+    scene.materials.back().emission *= 0.5;
+    check(renderBoth(scene, camera, settings, cache, "relight"), "material and light changes reuse the cache");
+
+    // Another scene, changed and rendered through its own cache, is no change to this one.
+    Scene other = scene;
+    other.spheres[0].translate(1.0, 0.0, 0.0);
+    PreparedScene otherPrepared(other);
+    GBufferCache otherCache;
+    FrameBuffer otherImage;
+    Renderer::render(otherPrepared, camera, settings, otherImage, otherCache);
+    check(renderBoth(scene, camera, settings, cache, "unrelated"), "rendering another scene reuses the cache");
+
+    scene.spheres[2].translate(0.0, 0.2, 0.0);
+    check(!renderBoth(scene, camera, settings, cache, "move"), "moving a sphere invalidates the cache");
+
+    scene.spheres[1].c.x += 0.1;
+    check(!renderBoth(scene, camera, settings, cache, "direct"), "writing a sphere's fields invalidates the cache");
+
+    Camera moved = camera;
+    moved.eye.x += 0.1;
+    check(!renderBoth(scene, moved, settings, cache, "camera"), "moving the camera invalidates the cache");
+
+    settings.spp = 5;
+    check(!renderBoth(scene, moved, settings, cache, "spp"), "changing the sample count invalidates the cache");
+
+    return checkResult();
+}
@@ -0,0 +1,65 @@
+/**
+* Checks that the packed store finds the same hits as the double precision spheres it was
+* built from, to within the float rounding of the geometry.
+*/
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include "../infrastructure/render/prepared_scene.h"
+#include "check.h"
+
+using namespace std;
+using namespace bla;
+
+int main() {
+    mt19937_64 rng(31);
+    uniform_real_distribution<double> u(-1.0, 1.0);
+
+    Scene scene;
+    for (int i = 0; i < 200; i++) {
+        Vector3 c(u(rng) * 20.0, u(rng) * 20.0, u(rng) * 20.0);
+        scene.add(Sphere(c, 0.3 + 1.5 * fabs(u(rng))), Material());
+    }
+    PreparedScene prepared(scene, Accelerator::None);
+
+    // Float centers of spheres some 20 units out are off by up to about 1e-6.
+    const double tolerance = 1e-5;
+    size_t rays = 20000, misses = 0, hits = 0, ties = 0;
+    double worst = 0.0;
+    for (size_t i = 0; i < rays; i++) {
+        Vector3 o(u(rng) * 30.0, u(rng) * 30.0, u(rng) * 30.0), d(u(rng), u(rng), u(rng));
+        d.norm();
+        Ray3 ray(o, d);
+        Hit exact, packed;
+        bool a = scene.intersect(ray, numeric_limits<double>::infinity(), exact);
+        bool b = prepared.intersect(ray, numeric_limits<double>::infinity(), packed);
+        if (a != b) {
+            // Only rays that graze a surface to within the rounding can see it in one and not the other.
+            const Sphere &s = scene.spheres[a ? exact.prim : packed.prim];
+            Vector3 p = ray.o - s.c;
+            double distance = sqrt(max(0.0, p.sqr() - (p * d) * (p * d)));
+            bool grazing = fabs(distance - s.r) < tolerance;
+            misses += !grazing;
+            continue;
+        }
+        if (!a)
+            continue;
+        hits++;
+        // Two surfaces closer than the rounding along the ray may swap places.
+        if (exact.prim != packed.prim) {
+            ties += fabs(exact.t - packed.t) > tolerance;
+            continue;
+        }
+        // Along grazing rays t moves a lot for a small change of the surface, so measure in space.
+        const Sphere &s = scene.spheres[exact.prim];
+        worst = fmax(worst, fabs((packed.p - s.c).len() - s.r));
+    }
+    cout << "      " << hits << " hits, hit points up to " << worst << " off the spheres" << endl;
+    check(hits > rays / 10, "enough rays hit something");
+    check(misses == 0, "the store hits what the spheres hit, except at grazing angles");
+    check(ties == 0, "the store hits the same primitive, unless two surfaces are closer than the rounding");
+    check(worst < tolerance, "hit points lie on the spheres to within the float rounding of the geometry");
+
+    return checkResult();
+}
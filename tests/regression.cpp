@@ -0,0 +1,207 @@
+/**
+* Regression test for one reference scene: renders it, compares the result to a golden
+* image and, given --baseline, checks the throughput against a baseline of the same machine.
+*
+* Images are compared in CIELAB: the render fails if more than a small share of its pixels
+* differ from the golden image by more than the tolerance (CIE76 delta E, where about 1 is
+* just noticeable). Sampling is deterministic, so refactoring the math leaves the 8 bit image
+* unchanged or nearly so, while a radius off by a few percent or a light a few percent too
+* bright already moves several percent of the pixels. Anything that changes which random
+* numbers are drawn changes the noise everywhere and needs new golden images.
+*
+* Throughput is the best rays/sec of several single threaded renders. A missing baseline
+* fails the check rather than being recorded, so a fresh build tree cannot pass it by
+* measuring itself; --update-baseline records one. It is never raised automatically, so a
+* lucky run cannot make later runs fail.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../infrastructure/render/image.h"
+#include "../infrastructure/render/renderer.h"
+#include "../infrastructure/render/scene_io.h"
+
+using namespace std;
+using namespace bla;
+
+/**
+ * Converts a linear sRGB color to CIELAB (D65 white point).
+ */
+static Vector3 toLab(const Vector3 &c) {
+    double x = (0.4124 * c.x + 0.3576 * c.y + 0.1805 * c.z) / 0.95047;
+    double y = 0.2126 * c.x + 0.7152 * c.y + 0.0722 * c.z;
+    double z = (0.0193 * c.x + 0.1192 * c.y + 0.9505 * c.z) / 1.08883;
+
+    auto f = [](double t) {
+        return t > 216.0 / 24389.0 ? cbrt(t) : (24389.0 / 27.0 * t + 16.0) / 116.0;
+    };
+    double fx = f(x), fy = f(y), fz = f(z);
+    return Vector3(116.0 * fy - 16.0, 500.0 * (fx - fy), 200.0 * (fy - fz));
+}
+
+/**
+ * @return the CIE76 color difference of every pixel
+ */
+static vector<double> colorDifferences(const vector<Vector3> &a, const vector<Vector3> &b) {
+    vector<double> diff(a.size());
+    for (size_t i = 0; i < a.size(); i++)
+        diff[i] = toLab(a[i]).dist(toLab(b[i]));
+    return diff;
+}
+
+static bool readBaseline(const string &path, double &raysPerSecond) {
+    ifstream in(path);
+    return (bool) (in >> raysPerSecond);
+}
+
+static bool writeBaseline(const string &path, double raysPerSecond) {
+    ofstream out(path);
+    out << raysPerSecond << "\n";
+    return (bool) out;
+}
+
+static void usage() {
+    cerr << "usage: bla_regression --scene FILE --golden FILE.ppm --out FILE.ppm [--baseline FILE]\n"
+            "                      [--tolerance DELTA_E] [--max-pixels PERCENT] [--max-slowdown PERCENT]\n"
+            "                      [--runs N] [--update-golden] [--update-baseline]" << endl;
+}
+
+int main(int argc, char **argv) {
+    string scenePath, goldenPath, outPath, baselinePath;
+    double tolerance = 1.0;
+    double maxPixels = 0.5;
+    double maxSlowdown = 15.0;
+    int runs = 3;
+    bool updateGolden = false, updateBaseline = false;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--update-golden") {
+            updateGolden = true;
+        } else if (arg == "--update-baseline") {
+            updateBaseline = true;
+        } else if (arg == "--scene" && hasValue) {
+            scenePath = argv[++i];
+        } else if (arg == "--golden" && hasValue) {
+            goldenPath = argv[++i];
+        } else if (arg == "--out" && hasValue) {
+            outPath = argv[++i];
+        } else if (arg == "--baseline" && hasValue) {
+            baselinePath = argv[++i];
+        } else if (arg == "--tolerance" && hasValue) {
+            tolerance = atof(argv[++i]);
+        } else if (arg == "--max-pixels" && hasValue) {
+            maxPixels = atof(argv[++i]);
+        } else if (arg == "--max-slowdown" && hasValue) {
+            maxSlowdown = atof(argv[++i]);
+        } else if (arg == "--runs" && hasValue) {
+            runs = max(1, atoi(argv[++i]));
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (scenePath.empty() || goldenPath.empty() || outPath.empty()) {
+        usage();
+        return 1;
+    }
+
+    Scene scene;
+    string text, error;
+    if (!readTextFile(scenePath, text) || !parseScene(text, scene, error)) {
+        cerr << scenePath << ": " << (error.empty() ? "could not read" : error) << endl;
+        return 1;
+    }
+
+    // Fixed settings, so goldens and baselines stay comparable. One thread keeps the
+    // throughput independent of what else the machine is doing on other cores.
+    RenderSettings settings;
+    settings.width = 128;
+    settings.height = 96;
+    settings.spp = 16;
+    settings.maxDepth = 4;
+    settings.threads = 1;
+    settings.seed = 1;
+    Camera camera(Vector3(0.0, 1.5, -6.0), Vector3(0.0, 0.7, 0.0), VEC_J, 40.0,
+                  (double) settings.width / settings.height);
+
+    PreparedScene prepared(scene);
+    FrameBuffer fb;
+    double raysPerSecond = 0.0;
+    for (int r = 0; r < runs; r++)
+        raysPerSecond = max(raysPerSecond, Renderer::render(prepared, camera, settings, fb).raysPerSecond());
+
+    bool ok = true;
+
+    // The render goes through the same 8 bit encoding as the golden image before comparing.
+    vector<Vector3> actual, golden;
+    int width, height, goldenWidth, goldenHeight;
+    if (!writePPM(outPath, fb.color, fb.width, fb.height) || !readPPM(outPath, actual, width, height)) {
+        cerr << "could not write " << outPath << endl;
+        return 1;
+    }
+    if (updateGolden) {
+        if (!writePPM(goldenPath, fb.color, fb.width, fb.height)) {
+            cerr << "could not write " << goldenPath << endl;
+            return 1;
+        }
+        cout << "updated " << goldenPath << endl;
+    } else if (!readPPM(goldenPath, golden, goldenWidth, goldenHeight)) {
+        cerr << "could not read golden image " << goldenPath << endl;
+        ok = false;
+    } else if (goldenWidth != width || goldenHeight != height) {
+        cerr << "golden image is " << goldenWidth << "x" << goldenHeight << ", render is "
+             << width << "x" << height << endl;
+        ok = false;
+    } else {
+        vector<double> diff = colorDifferences(actual, golden);
+        double mean = 0.0;
+        size_t different = 0;
+        for (double d : diff) {
+            mean += d;
+            if (d > tolerance)
+                different++;
+        }
+        mean /= diff.size();
+        double differentPercent = 100.0 * different / diff.size();
+
+        cout << "image: " << differentPercent << "% of pixels off by more than delta E " << tolerance
+             << " (max " << maxPixels << "%), mean delta E " << mean << endl;
+        if (differentPercent > maxPixels) {
+            cerr << "render differs from " << goldenPath << "; see " << outPath << endl;
+            ok = false;
+        }
+    }
+
+    cout << "throughput: " << raysPerSecond / 1e6 << " Mrays/s" << endl;
+    if (!baselinePath.empty() && maxSlowdown >= 0.0) {
+        double baseline;
+        if (updateBaseline) {
+            if (!writeBaseline(baselinePath, raysPerSecond)) {
+                cerr << "could not write " << baselinePath << endl;
+                return 1;
+            }
+            cout << "recorded baseline in " << baselinePath << endl;
+        } else if (!readBaseline(baselinePath, baseline)) {
+            cerr << "no throughput baseline in " << baselinePath << "; record one with --update-baseline" << endl;
+            ok = false;
+        } else {
+            double change = 100.0 * (raysPerSecond / baseline - 1.0);
+            cout << "baseline: " << baseline / 1e6 << " Mrays/s (" << showpos << change << noshowpos
+                 << "%, max -" << maxSlowdown << "%)" << endl;
+            if (change < -maxSlowdown) {
+                cerr << "throughput dropped more than " << maxSlowdown << "% below " << baselinePath << endl;
+                ok = false;
+            }
+        }
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,139 @@
+/**
+* Checks that the render server joins the threads of clients that left instead of keeping one
+* per connection it ever had, that a render stops when its client disconnects and that
+* requests which could render forever are rejected.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "../infrastructure/render/scene_io.h"
+#include "../infrastructure/server/render_server.h"
+#include "check.h"
+
+using namespace std;
+using namespace bla;
+
+static int connectTo(const string &path) {
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path.c_str());
+    for (int attempt = 0; attempt < 100; attempt++) {
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (::connect(fd, (sockaddr *) &addr, sizeof(addr)) == 0)
+            return fd;
+        ::close(fd);
+        this_thread::sleep_for(chrono::milliseconds(20));
+    }
+    return -1;
+}
+
+static void send(int fd, const string &text) {
+    ::send(fd, text.data(), text.size(), MSG_NOSIGNAL);
+}
+
+static string readLine(int fd) {
+    string line;
+    char c;
+    while (::recv(fd, &c, 1, 0) == 1 && c != '\n')
+        line += c;
+    return line;
+}
+
+/**
+ * @return the virtual memory size of this process in kB, which includes the stacks of threads
+ * that exited but were never joined
+ */
+static long vmSize() {
+    ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line)) {
+        if (line.compare(0, 7, "VmSize:") == 0)
+            return atol(line.c_str() + 7);
+    }
+    return -1;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        cerr << "usage: bla_render_server SCENE SOCKET" << endl;
+        return 1;
+    }
+    string scene;
+    if (!readTextFile(argv[1], scene)) {
+        cerr << argv[1] << ": could not read" << endl;
+        return 1;
+    }
+
+    ServerSettings settings;
+    settings.socketPath = argv[2];
+    settings.threads = 1;
+    RenderServer server(settings);
+    string error;
+    thread serving([&]() { server.run(error); });
+    int fd = connectTo(settings.socketPath);
+    send(fd, "QUIT\n");
+    readLine(fd);
+    ::close(fd);
+    long before = vmSize();
+
+    for (int i = 0; i < 200; i++) {
+        int fd = connectTo(settings.socketPath);
+        send(fd, "QUIT\n");
+        readLine(fd);
+        ::close(fd);
+    }
+    // One more round trip, so the server has accepted (and reaped) after the last QUIT.
+    fd = connectTo(settings.socketPath);
+    send(fd, "PING\n");
+    readLine(fd);
+    long growth = vmSize() - before;
+    cout << "      " << growth << " kB more virtual memory after 200 connections" << endl;
+    // Every thread that is never joined keeps its stack of several MB.
+    check(before > 0 && growth < 64 * 1024, "threads of finished connections are joined");
+
+    send(fd, "LOAD " + to_string(scene.size()) + "\n" + scene);
+    string key = readLine(fd);
+    check(key.compare(0, 3, "OK ") == 0, "the scene loads");
+    key = key.substr(3);
+
+    // A render that takes minutes unless it stops when its client leaves.
+    auto start = chrono::steady_clock::now();
+    send(fd, "RENDER scene=" + key + " width=2048 height=2048 spp=256\n");
+    check(readLine(fd).compare(0, 5, "TILE ") == 0, "the big render sends tiles");
+    ::close(fd);
+
+    fd = connectTo(settings.socketPath);
+    send(fd, "RENDER scene=" + key + " width=8 height=8 spp=1\n");
+    string line;
+    int x0, y0, x1, y1;
+    while (sscanf((line = readLine(fd)).c_str(), "TILE %d %d %d %d", &x0, &y0, &x1, &y1) == 4) {
+        vector<float> pixels((size_t) (x1 - x0) * (y1 - y0) * 3);
+        ::recv(fd, pixels.data(), pixels.size() * sizeof(float), MSG_WAITALL);
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "      the next render finished after " << seconds << " s" << endl;
+    check(line == "DONE" && seconds < 60.0, "a render stops when its client disconnects");
+
+    bool rejected = true;
+    for (const char *arg : {"depth=-1", "depth=100000", "fov=0", "fov=180", "fov=-30"}) {
+        send(fd, "RENDER scene=" + key + " width=8 height=8 spp=1 " + arg + "\n");
+        rejected &= readLine(fd).compare(0, 4, "ERR ") == 0;
+    }
+    check(rejected, "renders with a negative or huge depth or a degenerate fov are rejected");
+
+    send(fd, "SHUTDOWN\n");
+    readLine(fd);
+    ::close(fd);
+    serving.join();
+    return checkResult();
+}
@@ -0,0 +1,61 @@
+/**
+* Checks that world matrices read between frames leave no node of the scene graph stale: the
+* siblings of a node whose world matrix was asked for still get updated and flattened, also
+* after they move again themselves. Also checks that nodes without a sphere never add one and
+* that a sphere is written once per flatten however often it changed.
+*/
+
+#include <iostream>
+#include "../infrastructure/scene/scene_graph.h"
+#include "check.h"
+
+using namespace std;
+using namespace bla;
+
+static bool near(const Vector3 &a, const Vector3 &b) {
+    return (a - b).len() <= 1e-12;
+}
+
+int main() {
+    SceneGraph graph;
+    SceneNode *root = graph.getRoot();
+    SceneNode *a = root->createChild();
+    SceneNode *b = root->createChild();
+    a->setSphere(Sphere(VEC_ZERO, 0.5), Material());
+    b->setSphere(Sphere(VEC_ZERO, 0.5), Material());
+    a->translate(-1.0, 0.0, 0.0);
+    b->translate(1.0, 0.0, 0.0);
+    Scene scene;
+    graph.flatten(scene);
+    check(near(scene.spheres[0].c, Vector3(-1.0, 0.0, 0.0)) && near(scene.spheres[1].c, Vector3(1.0, 0.0, 0.0)),
+          "first flatten places both spheres");
+
+    root->translate(0.0, 2.0, 0.0);
+    a->getWorld();
+    graph.flatten(scene);
+    check(near(scene.spheres[0].c, Vector3(-1.0, 2.0, 0.0)), "the node read between frames moves with the root");
+    check(near(scene.spheres[1].c, Vector3(1.0, 2.0, 0.0)), "its sibling moves with the root too");
+    check(!a->isDirty() && !b->isDirty(), "no node is left dirty after the flatten");
+
+    root->translate(0.0, 1.0, 0.0);
+    a->getWorld();
+    b->translate(0.0, 0.0, 3.0);
+    graph.flatten(scene);
+    check(near(scene.spheres[1].c, Vector3(1.0, 3.0, 3.0)), "a sibling moved after the read is flattened where it is");
+
+    Material red(Vector3(1.0, 0.0, 0.0));
+    root->setMaterial(red);
+    graph.flatten(scene);
+    check(scene.spheres.size() == 2, "a material on a node without a sphere adds nothing");
+
+    for (int i = 0; i < 3; i++) {
+        a->translate(0.0, 0.0, 1.0);
+        a->setMaterial(red);
+        graph.update();
+    }
+    size_t written = graph.flatten(scene);
+    check(written == 1 && scene.spheres.size() == 2 && near(scene.spheres[0].c, Vector3(-1.0, 3.0, 3.0)) &&
+          scene.materials[0].albedo.y == 0.0, "a sphere changed over several updates is written once");
+
+    return checkResult();
+}
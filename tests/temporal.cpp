@@ -0,0 +1,128 @@
+/**
+* Checks that temporal reuse carries samples over a small camera move to pixels that still
+* match a full render, and that it drops the history of pixels whose lighting changed: after an
+* occluder far above the ground moves, its long shadow has to move in the reprojected frame as
+* well, and the frame has to match a full render of the new scene up to noise.
+*/
+
+#include <cmath>
+#include <iostream>
+#include "../infrastructure/render/color.h"
+#include "../infrastructure/render/temporal.h"
+#include "check.h"
+
+using namespace std;
+using namespace bla;
+
+/**
+ * @return the largest difference in mean luminance between the 8x8 blocks of two frames
+ */
+static double worstBlock(const FrameBuffer &a, const FrameBuffer &b) {
+    double worst = 0.0;
+    for (int by = 0; by + 8 <= a.height; by += 8) {
+        for (int bx = 0; bx + 8 <= a.width; bx += 8) {
+            double sum = 0.0;
+            for (int y = by; y < by + 8; y++) {
+                for (int x = bx; x < bx + 8; x++)
+                    sum += luminance(a.color[a.index(x, y)]) - luminance(b.color[b.index(x, y)]);
+            }
+            worst = fmax(worst, fabs(sum) / 64.0);
+        }
+    }
+    return worst;
+}
+
+/**
+ * Renders two frames with the camera moved a little in between and compares the pixels of the
+ * second frame that were carried over against a much less noisy full render of it.
+ */
+static void cameraMotion(RenderSettings settings, Camera camera) {
+    // Small shaded spheres and their shadows: colors change within a few pixels everywhere.
+    Scene scene;
+    scene.add(Sphere(Vector3(0.0, -1000.0, 0.0), 1000.0), Material(Vector3(0.7, 0.7, 0.7)));
+    scene.add(Sphere(Vector3(-3.0, 8.0, -2.0), 1.0), Material(VEC_ZERO, Vector3(40.0, 40.0, 40.0)));
+    for (int i = 0; i < 9; i++) {
+        scene.add(Sphere(Vector3(-2.0 + 2.0 * (i % 3), 0.5, -1.0 + 2.0 * (i / 3)), 0.5),
+                  Material(Vector3(0.2 + 0.1 * i, 0.9 - 0.08 * i, 0.5)));
+    }
+
+    TemporalRenderer temporal(settings);
+    FrameBuffer first, second, reference;
+    PreparedScene prepared(scene);
+    temporal.renderFrame(prepared, camera, nullptr, first);
+
+    camera.eye += Vector3(0.3, 0.1, 0.0);
+    camera.target += Vector3(0.2, 0.0, 0.0);
+    TemporalStats stats = temporal.renderFrame(prepared, camera, nullptr, second);
+    settings.spp *= 16;
+    settings.seed = 99;
+    Renderer::render(prepared, camera, settings, reference);
+
+    double lit = 0.0;
+    for (const Vector3 &c : reference.color)
+        lit = fmax(lit, luminance(c));
+
+    // Fresh samples come from a new seed, so a pixel is carried over if it has exactly the
+    // color one of its neighbors had in the previous frame.
+    size_t reused = 0, off = 0;
+    for (int y = 0; y < settings.height; y++) {
+        for (int x = 0; x < settings.width; x++) {
+            size_t i = second.index(x, y);
+            bool carried = false;
+            for (int dy = -3; dy <= 3 && !carried; dy++) {
+                for (int dx = -3; dx <= 3 && !carried; dx++) {
+                    int px = x + dx, py = y + dy;
+                    carried = px >= 0 && py >= 0 && px < settings.width && py < settings.height &&
+                              second.color[i] == first.color[first.index(px, py)];
+                }
+            }
+            if (!carried || second.depth[i] == 0.0)
+                continue;
+            reused++;
+            double error = fabs(luminance(second.color[i]) - luminance(reference.color[i]));
+            off += error > 5.0 * sqrt(second.variance[i] + reference.variance[i]) + 0.01 * lit;
+        }
+    }
+    cout << "      camera moved: " << stats.reused << " pixels reused, " << off << " of the " << reused
+         << " carried over pixels on surfaces off the full render" << endl;
+    check(stats.reused > 0 && reused > 0, "pixels keep their history when the camera moves a little");
+    check(off <= reused / 100, "carried over pixels match a full render of the new view");
+}
+
+int main() {
+    Scene scene;
+    scene.add(Sphere(Vector3(0.0, -1000.0, 0.0), 1000.0), Material(Vector3(0.7, 0.7, 0.7)));
+    scene.add(Sphere(Vector3(0.0, 10.0, 0.0), 1.0), Material(VEC_ZERO, Vector3(40.0, 40.0, 40.0)));
+    // Five units above the ground, six radii away from its own shadow.
+    int occluder = scene.add(Sphere(Vector3(0.0, 5.0, 0.0), 0.8), Material(Vector3(0.7, 0.7, 0.7)));
+
+    RenderSettings settings;
+    settings.width = 64;
+    settings.height = 48;
+    settings.spp = 16;
+    settings.maxDepth = 1;
+    Camera camera(Vector3(0.0, 3.0, -7.0), Vector3(1.5, 0.0, 0.0), VEC_J, 60.0,
+                  (double) settings.width / settings.height);
+
+    cameraMotion(settings, camera);
+
+    TemporalRenderer temporal(settings);
+    FrameBuffer first, second, full;
+    temporal.renderFrame(PreparedScene(scene), camera, nullptr, first);
+
+    scene.spheres[occluder].translate(2.0, 0.0, 0.0);
+    PreparedScene moved(scene);
+    TemporalStats stats = temporal.renderFrame(moved, camera, nullptr, second);
+    Renderer::render(moved, camera, settings, full);
+
+    double lit = 0.0;
+    for (const Vector3 &c : full.color)
+        lit = fmax(lit, luminance(c));
+    double stale = worstBlock(second, full), shift = worstBlock(first, full);
+    cout << "      " << stats.reused << " pixels reused; worst block off by " << stale << " against "
+         << shift << " for the unmoved shadow, brightest pixel " << lit << endl;
+    check(shift > 0.2 * lit, "moving the occluder moves its shadow");
+    check(stale < 0.1 * lit, "the reprojected frame matches a full render after the occluder moved");
+    check(stats.reused > 0, "pixels away from the shadow keep their history");
+    return checkResult();
+}
@@ -0,0 +1,60 @@
+/**
+* Checks that binning primary rays into tiles changes nothing in the image, for spheres in
+* front of, around and behind the eye, and that spheres behind the eye are in no tile.
+*/
+
+#include <iostream>
+#include <random>
+#include "../infrastructure/render/renderer.h"
+#include "check.h"
+
+using namespace std;
+using namespace bla;
+
+int main() {
+    mt19937_64 rng(33);
+    uniform_real_distribution<double> u(-1.0, 1.0);
+
+    Scene scene;
+    scene.background = Vector3(0.2, 0.3, 0.4);
+    for (int i = 0; i < 300; i++) {
+        Vector3 c(u(rng) * 12.0, u(rng) * 12.0, u(rng) * 12.0);
+        scene.add(Sphere(c, 0.2 + 0.8 * fabs(u(rng))),
+                  Material(Vector3(0.5 + 0.4 * u(rng), 0.5, 0.5), i % 25 == 0 ? Vector3(4.0, 4.0, 4.0) : VEC_ZERO));
+    }
+    // One sphere around the eye, which every tile has to test.
+    scene.add(Sphere(VEC_ZERO, 30.0), Material(Vector3(0.3, 0.3, 0.3)));
+
+    RenderSettings settings;
+    settings.width = 80;
+    settings.height = 60;
+    settings.spp = 2;
+    settings.maxDepth = 2;
+    settings.accelerator = Accelerator::None;
+    Camera camera(VEC_ZERO, VEC_K, VEC_J, 70.0, (double) settings.width / settings.height);
+    PreparedScene prepared(scene, settings.accelerator);
+
+    FrameBuffer binned, unbinned;
+    Renderer::render(prepared, camera, settings, binned);
+    settings.binPrimary = false;
+    Renderer::render(prepared, camera, settings, unbinned);
+    check(sameImage(binned, unbinned), "renders are identical with and without binning");
+
+    TileBins bins(prepared.store, camera, settings.width, settings.height, settings.renderRegion(),
+                  settings.tileSize);
+    size_t tiles = makeTiles(settings.renderRegion(), settings.tileSize).size();
+    bool behindCulled = true, aroundEverywhere = true;
+    for (size_t t = 0; t < tiles; t++) {
+        PrimitiveList list = bins.candidates((int) t);
+        bool around = false;
+        for (size_t i = 0; i < list.count; i++) {
+            const Sphere &s = scene.spheres[list.ids[i]];
+            behindCulled &= s.c.z >= -s.r;
+            around |= list.ids[i] == scene.size() - 1;
+        }
+        aroundEverywhere &= around;
+    }
+    check(behindCulled, "spheres behind the eye are in no tile");
+    check(aroundEverywhere, "a sphere around the eye is in every tile");
+    return checkResult();
+}
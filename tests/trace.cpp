@@ -0,0 +1,89 @@
+/**
+* Checks that tracing records nothing while off, that a traced render has one span per tile
+* next to the build spans, and that full rings keep the newest spans. The cost of a span while
+* off is printed, not checked, since wall clock limits fail on loaded machines.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include "../infrastructure/render/renderer.h"
+#include "../infrastructure/render/scene_io.h"
+#include "../infrastructure/render/trace.h"
+#include "check.h"
+
+using namespace std;
+using namespace bla;
+
+static size_t occurrences(const string &text, const string &what) {
+    size_t n = 0;
+    for (size_t at = text.find(what); at != string::npos; at = text.find(what, at + 1))
+        n++;
+    return n;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        cerr << "usage: bla_trace SCENE TRACE" << endl;
+        return 1;
+    }
+    Scene scene;
+    string text, error;
+    if (!readTextFile(argv[1], text) || !parseScene(text, scene, error)) {
+        cerr << argv[1] << ": " << (error.empty() ? "could not read" : error) << endl;
+        return 1;
+    }
+
+    RenderSettings settings;
+    settings.width = 64;
+    settings.height = 48;
+    settings.spp = 2;
+    settings.tileSize = 16;
+    settings.threads = 2;
+    Camera camera(Vector3(0.0, 1.5, -6.0), Vector3(0.0, 0.7, 0.0), VEC_J, 40.0,
+                  (double) settings.width / settings.height);
+    size_t tiles = makeTiles(settings.renderRegion(), settings.tileSize).size();
+
+    FrameBuffer fb;
+    Renderer::render(scene, camera, settings, fb);
+    check(occurrences(Trace::json(), "\"ph\":\"X\"") == 0, "nothing is recorded while tracing is off");
+
+    const int spans = 10000000;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < spans; i++)
+        TraceSpan span("off", "test", i);
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / spans;
+    cout << "      " << ns << " ns per span while off" << endl;
+
+    Trace::start();
+    Renderer::render(scene, camera, settings, fb);
+    Trace::stop();
+    string json = Trace::json();
+    check(occurrences(json, "\"name\":\"tile\"") == tiles, "every tile has a span");
+    check(occurrences(json, "\"name\":\"render\"") == 1 && occurrences(json, "\"name\":\"primitive store\"") == 1 &&
+          occurrences(json, "\"name\":\"light bvh\"") == 1, "the scene build and the render have spans");
+    check(occurrences(json, "\"name\":\"thread_name\"") >= 1, "threads are named");
+    bool ok = Trace::write(argv[2], error);
+    check(ok, ok ? "the trace is written" : error);
+    remove(argv[2]);
+
+    Trace::start(8);
+    for (int i = 0; i < 20; i++)
+        TraceSpan span("step", "test", i);
+    Trace::stop();
+    json = Trace::json();
+    check(occurrences(json, "\"ph\":\"X\"") == 8 && json.find("\"index\":11}") == string::npos &&
+          json.find("\"index\":12}") != string::npos && json.find("\"index\":19}") != string::npos,
+          "a full ring keeps the newest spans");
+
+    Trace::start(0);
+    for (int i = 0; i < 3; i++)
+        TraceSpan span("step", "test", i);
+    Trace::stop();
+    json = Trace::json();
+    check(occurrences(json, "\"ph\":\"X\"") == 1 && json.find("\"index\":2}") != string::npos,
+          "a ring asked to hold nothing keeps the newest span");
+
+    return checkResult();
+}
@@ -0,0 +1,151 @@
+/**
+* Checks that TRS transforms agree with the matrices they bake to and decompose from, that
+* long chains of rotations stay rigid, that poses interpolate along the shorter arc and that
+* scene nodes and spheres take them, rotation and scale included.
+*/
+
+#include <cmath>
+#include <iostream>
+#include <string>
+#include "../infrastructure/math/trs.h"
+#include "../infrastructure/scene/scene_graph.h"
+#include "check.h"
+
+using namespace std;
+using namespace bla;
+
+static bool near(const Vector3 &a, const Vector3 &b, double eps = 1e-12) {
+    return (a - b).len() <= eps;
+}
+
+static bool near(const Matrix4 &a, const Matrix4 &b, double eps = 1e-12) {
+    array<double, 16> m = a.getMatrix(), n = b.getMatrix();
+    for (int i = 0; i < 16; i++) {
+        if (fabs(m[i] - n[i]) > eps)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @return how far the upper left 3x3 block of <b>M</b> is from a rotation
+ */
+static double rigidityError(const Matrix4 &M) {
+    array<double, 16> m = M.getMatrix();
+    double worst = 0.0;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            double d = m[i * 4] * m[j * 4] + m[i * 4 + 1] * m[j * 4 + 1] + m[i * 4 + 2] * m[j * 4 + 2];
+            worst = fmax(worst, fabs(d - (i == j ? 1.0 : 0.0)));
+        }
+    }
+    return worst;
+}
+
+int main() {
+    Vector3 probes[] = {Vector3(1.0, 0.0, 0.0), Vector3(0.3, -2.0, 0.7), Vector3(-1.5, 0.25, 4.0)};
+
+    bool axes = true;
+    for (const Vector3 &p : probes) {
+        axes &= near(Quaternion::getRotXInstance(0.7).rotate(p), Matrix4::getRotXInstance(0.7).getTransformedVec(p));
+        axes &= near(Quaternion::getRotYInstance(0.7).rotate(p), Matrix4::getRotYInstance(0.7).getTransformedVec(p));
+        axes &= near(Quaternion::getRotZInstance(0.7).rotate(p), Matrix4::getRotZInstance(0.7).getTransformedVec(p));
+    }
+    check(axes, "quaternion axis rotations match the Matrix4 ones");
+
+    TRS a(Vector3(1.0, 2.0, -3.0), Quaternion::getRotationInstance(Vector3(1.0, 1.0, 0.0), 0.9), Vector3(2.0, 2.0, 2.0));
+    TRS b(Vector3(-0.5, 0.0, 4.0), Quaternion::getRotationInstance(Vector3(0.0, 1.0, 2.0), -1.3), Vector3(1.0, 3.0, 0.5));
+    bool baked = true;
+    for (const Vector3 &p : probes)
+        baked &= near(b.transformVec(p), b.getMatrix().getTransformedVec(p));
+    check(baked, "baked matrix transforms like the TRS");
+    check(near((a * b).getMatrix(), a.getMatrix().getMult(b.getMatrix())), "TRS product matches the matrix product");
+    TRS stretch(VEC_ZERO, Quaternion(), Vector3(2.0, 1.0, 1.0)), quarter(VEC_ZERO, Quaternion::getRotZInstance(M_PI / 2));
+    check(near((stretch * quarter).transformVec(VEC_I), Vector3(0.0, 1.0, 0.0)) &&
+          near((stretch * quarter).transformVec(VEC_J), Vector3(-2.0, 0.0, 0.0)),
+          "a non-uniform scale over a rotation scales the rotated axes");
+    check(near((a * a.getInverse()).getMatrix(), Matrix4()), "TRS times its inverse is the identity");
+
+    // A long animation chain: many small rotations around alternating axes.
+    TRS chain;
+    Matrix4 matrix;
+    for (int i = 0; i < 100000; i++) {
+        chain.rotX(0.001, false)->rotY(0.0013, false);
+        matrix.rotX(0.001, false)->rotY(0.0013, false);
+    }
+    double chainError = rigidityError(chain.getMatrix());
+    cout << "      after 200000 rotations: TRS off by " << chainError << ", Matrix4 by "
+         << rigidityError(matrix) << endl;
+    check(chainError < 1e-14, "long rotation chains stay rigid");
+
+    TRS start(VEC_ZERO, Quaternion()), end(Vector3(2.0, 0.0, 0.0), Quaternion::getRotYInstance(M_PI / 2));
+    TRS mid = TRS::interpolate(start, end, 0.5);
+    check(near(TRS::interpolate(start, end, 0.0).getMatrix(), start.getMatrix()) &&
+          near(TRS::interpolate(start, end, 1.0).getMatrix(), end.getMatrix()), "interpolation hits both ends");
+    check(near(mid.translation, Vector3(1.0, 0.0, 0.0)) &&
+          near(mid.rotation.rotate(VEC_I), Matrix4::getRotYInstance(M_PI / 4).getTransformedVec(VEC_I)),
+          "interpolation halves the angle");
+    Quaternion flipped(-end.rotation.w, -end.rotation.x, -end.rotation.y, -end.rotation.z);
+    check(near(Quaternion::slerp(start.rotation, flipped, 0.5).rotate(VEC_I), mid.rotation.rotate(VEC_I)),
+          "interpolation takes the shorter arc");
+
+    Matrix4 sheared = b.getMatrix().getMult(Matrix4::getAffineInstance(VEC_I, Vector3(0.3, 1.0, 0.0), VEC_K, VEC_ZERO));
+    check(near(TRS::fromMatrix(a.getMatrix()).getMatrix(), a.getMatrix()) &&
+          near(TRS::fromMatrix(Matrix4::getRotYInstance(2.5)).getMatrix(), Matrix4::getRotYInstance(2.5)),
+          "decomposing a baked matrix gives the TRS back");
+    check(near(TRS::fromMatrix(sheared).getMatrix().getTransformedVec(VEC_I), sheared.getTransformedVec(VEC_I)),
+          "decomposing a sheared matrix only drops the shear");
+
+    SceneGraph graph;
+    SceneNode *parent = graph.getRoot()->createChild();
+    SceneNode *node = parent->createChild();
+    node->transform(a);
+    check(near(node->getLocal().getMatrix(), a.getMatrix()), "a SceneNode accepts a TRS");
+    node->setSphere(Sphere(Vector3(0.5, 0.0, 0.0), 0.25), Material());
+    parent->setLocal(TRS(Vector3(0.0, 1.0, 0.0), Quaternion::getRotZInstance(0.4), Vector3(3.0, 3.0, 3.0)));
+    Scene flat;
+    graph.flatten(flat);
+    check(near(flat.spheres[0].c, parent->getLocal().transformVec(a.transformVec(Vector3(0.5, 0.0, 0.0)))) &&
+          fabs(flat.spheres[0].r - 0.25 * 2.0 * 3.0) < 1e-12, "SceneNode world transforms compose the TRS");
+
+    // A non-uniform scale above a rotated child: the world matrix has a shear no TRS can hold.
+    SceneNode *stretched = graph.getRoot()->createChild();
+    SceneNode *turned = stretched->createChild();
+    stretched->setLocal(stretch);
+    turned->setLocal(quarter);
+    turned->setSphere(Sphere(VEC_I, 0.25), Material());
+    graph.flatten(flat);
+    check(near(flat.spheres[1].c, stretch.getMatrix().getMult(quarter.getMatrix()).getTransformedVec(VEC_I)) &&
+          near(flat.spheres[1].c, Vector3(0.0, 1.0, 0.0)) && fabs(flat.spheres[1].r - 0.5) < 1e-12,
+          "SceneNode world transforms follow the matrix product under a non-uniform scale");
+
+    // SceneNode rotations chain on the TRS, not on a matrix, so they stay rigid as well.
+    for (int i = 0; i < 100000; i++) {
+        node->rotX(0.001, false);
+        node->rotY(0.0013, false);
+    }
+    check(rigidityError(TRS(VEC_ZERO, node->getLocal().rotation).getMatrix()) < 1e-14,
+          "long SceneNode rotation chains stay rigid");
+
+    Sphere s(Vector3(1.0, 1.0, 1.0), 0.5);
+    s.transform(TRS(Vector3(0.0, 2.0, 0.0), Quaternion()));
+    check(near(s.c, Vector3(1.0, 3.0, 1.0)), "a Sphere accepts a TRS");
+    s = Sphere(Vector3(1.0, 0.0, 0.0), 0.5);
+    s.transform(TRS(VEC_ZERO, Quaternion::getRotZInstance(M_PI / 2)));
+    check(near(s.c, Vector3(0.0, 1.0, 0.0)) && s.r == 0.5, "a Sphere turns around the origin with a TRS");
+    s = Sphere(Vector3(1.0, 2.0, 0.0), 0.5);
+    s.transform(TRS(Vector3(0.0, 0.0, 1.0), Quaternion(), Vector3(2.0, 2.0, 2.0)));
+    check(near(s.c, Vector3(2.0, 4.0, 1.0)) && fabs(s.r - 1.0) < 1e-15, "a Sphere scales with a TRS");
+
+    // Transformable promises that the TRS overload is the same as baking the matrix.
+    bool same = true;
+    for (const TRS &T : {a, b, quarter, stretch}) {
+        Sphere viaTRS(Vector3(1.0, -0.5, 2.0), 0.5), viaMatrix = viaTRS;
+        viaTRS.transform(T);
+        viaMatrix.transform(T.getMatrix());
+        same &= near(viaTRS.c, viaMatrix.c) && fabs(viaTRS.r - viaMatrix.r) < 1e-12;
+    }
+    check(same, "a Sphere transforms the same through a TRS and through its matrix");
+
+    return checkResult();
+}
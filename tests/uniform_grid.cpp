@@ -0,0 +1,106 @@
+/**
+* Checks that a UniformGrid finds exactly the hits testing every primitive finds, that the
+* automatic choice picks it for particle data only, and that renders do not change with it.
+*/
+
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include "../infrastructure/render/renderer.h"
+#include "check.h"
+
+using namespace std;
+using namespace bla;
+
+/**
+ * @return a cloud of small spheres of similar size over a huge ground sphere, lit by one of them
+ */
+static Scene buildParticles(size_t count, mt19937_64 &rng) {
+    uniform_real_distribution<double> u(0.0, 1.0);
+    Scene scene;
+    scene.add(Sphere(Vector3(0.0, -1000.0, 0.0), 1000.0), Material(Vector3(0.7, 0.7, 0.7)));
+    scene.add(Sphere(Vector3(0.0, 6.0, 0.0), 0.5), Material(VEC_ZERO, Vector3(20.0, 20.0, 20.0)));
+    for (size_t i = 0; i < count; i++) {
+        Vector3 c(u(rng) * 8.0 - 4.0, u(rng) * 4.0, u(rng) * 8.0 - 4.0);
+        scene.add(Sphere(c, 0.02 + 0.03 * u(rng)), Material(Vector3(u(rng), u(rng), u(rng))));
+    }
+    return scene;
+}
+
+/**
+ * @return the number of random rays the grid and a full scan disagree on
+ */
+static int compareHits(const PrimitiveStore &store, const UniformGrid &grid, mt19937_64 &rng, int rays) {
+    uniform_real_distribution<double> u(-1.0, 1.0);
+    int mismatches = 0;
+    for (int r = 0; r < rays; r++) {
+        // Half the rays start inside the cloud, the rest well outside it.
+        double spread = r % 2 == 0 ? 4.0 : 12.0;
+        Vector3 o(u(rng) * spread, 2.0 + u(rng) * spread, u(rng) * spread);
+        Vector3 d(u(rng), u(rng), u(rng));
+        d.norm();
+        if (r % 7 == 0)
+            d = Vector3(0.0, 0.0, r % 3 == 0 ? 1.0 : -1.0);
+        double tMax = r % 5 == 0 ? 1.0 : numeric_limits<double>::infinity();
+
+        Hit expected, actual;
+        bool e = store.intersect(Ray3(o, d), tMax, expected);
+        bool a = grid.intersect(store, Ray3(o, d), tMax, actual);
+        if (e != a || (e && (expected.prim != actual.prim || expected.t != actual.t)))
+            mismatches++;
+    }
+    return mismatches;
+}
+
+int main() {
+    mt19937_64 rng(38);
+
+    Scene particles = buildParticles(20000, rng);
+    PrimitiveStore store(particles);
+    check(UniformGrid::suits(store), "particle data gets a grid");
+
+    auto start = chrono::steady_clock::now();
+    UniformGrid grid(store);
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << "      " << store.size() << " primitives in " << grid.resolution(0) << "x" << grid.resolution(1) << "x"
+         << grid.resolution(2) << " cells, " << grid.memoryUsage() / 1024 << " KiB, built in " << ms << " ms"
+         << endl;
+    check(grid.outlierCount() == 2, "the ground and the light, far larger than a particle, stay out of the cells");
+    check(compareHits(store, grid, rng, 20000) == 0, "grid hits match testing every primitive");
+
+    Scene few;
+    few.add(Sphere(Vector3(0.0, -1000.0, 0.0), 1000.0), Material(Vector3(0.7, 0.7, 0.7)));
+    few.add(Sphere(Vector3(0.0, 0.8, 0.4), 0.8), Material(Vector3(0.2, 0.6, 0.8)));
+    few.add(Sphere(Vector3(0.5, 4.0, -1.5), 1.0), Material(VEC_ZERO, Vector3(8.0, 7.5, 7.0)));
+    PrimitiveStore fewStore(few);
+    check(!UniformGrid::suits(fewStore), "a handful of spheres is tested directly");
+    check(compareHits(fewStore, UniformGrid(fewStore), rng, 2000) == 0, "a forced grid over a handful matches");
+
+    Scene empty;
+    PrimitiveStore emptyStore(empty);
+    Hit hit;
+    check(!UniformGrid(emptyStore).intersect(emptyStore, Ray3(VEC_ZERO, VEC_J), 1.0, hit),
+          "an empty grid hits nothing");
+
+    RenderSettings settings;
+    settings.width = 64;
+    settings.height = 48;
+    settings.spp = 4;
+    settings.threads = 2;
+    Camera camera(Vector3(0.0, 3.0, -10.0), Vector3(0.0, 1.5, 0.0), VEC_J, 45.0,
+                  (double) settings.width / settings.height);
+    // Small enough that testing every primitive stays quick.
+    Scene cloud = buildParticles(2000, rng);
+    FrameBuffer direct, gridded;
+    settings.accelerator = Accelerator::None;
+    RenderStats directStats = Renderer::render(cloud, camera, settings, direct);
+    settings.accelerator = Accelerator::Grid;
+    RenderStats gridStats = Renderer::render(cloud, camera, settings, gridded);
+    cout << "      render: " << directStats.seconds << " s testing every primitive, " << gridStats.seconds
+         << " s with the grid" << endl;
+    check(sameImage(direct, gridded), "renders are identical with and without the grid");
+
+    return checkResult();
+}
@@ -0,0 +1,151 @@
+/**
+* Checks every bulk Vector3 kernel table this machine supports against the scalar Vector3
+* operations, with separate and aliased output arrays and lengths that exercise the scalar
+* tails, that all tables round alike, and that BLA_VEC3_ISA picks the table.
+*
+* With --expect NAME, also checks that vector3Kernels() picked the table called NAME, or the
+* fastest supported one for NAME "best".
+*/
+
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <random>
+#include "../infrastructure/math/vec3_bulk.h"
+#include "check.h"
+
+using namespace std;
+using namespace bla;
+
+static bool near(double a, double b, double eps = 1e-12) {
+    return fabs(a - b) <= eps * max(1.0, fabs(b));
+}
+
+static bool near(const Vector3Array &a, size_t i, const Vector3 &v) {
+    return near(a.x[i], v.x) && near(a.y[i], v.y) && near(a.z[i], v.z);
+}
+
+static Vector3Array randomArray(size_t n, mt19937_64 &rng) {
+    uniform_real_distribution<double> u(-10.0, 10.0);
+    Vector3Array a(n);
+    for (size_t i = 0; i < n; i++)
+        a.set(i, Vector3(u(rng), u(rng), u(rng)));
+    return a;
+}
+
+/**
+ * @return <b>true</b> if every kernel of <b>k</b> matches <code>Vector3</code> on <b>n</b> elements
+ */
+static bool matchesScalar(const Vector3Kernels &k, size_t n, bool aliased, mt19937_64 &rng) {
+    Vector3Array a = randomArray(n, rng), b = randomArray(n, rng);
+    const double s = 0.75;
+    bool ok = true;
+
+    vector<double> scalars(n);
+    k.dot(a.span(), b.span(), scalars.data(), n);
+    for (size_t i = 0; i < n; i++)
+        ok &= near(scalars[i], a.get(i) * b.get(i));
+    k.len(a.span(), scalars.data(), n);
+    for (size_t i = 0; i < n; i++)
+        ok &= near(scalars[i], a.get(i).len());
+    k.dist(a.span(), b.span(), scalars.data(), n);
+    for (size_t i = 0; i < n; i++)
+        ok &= near(scalars[i], a.get(i).dist(b.get(i)), 1e-6);
+
+    // Each vector operation writes into a copy of a when aliased, so out and the input are one array.
+    auto run = [&](const function<void(Vector3Span, Vector3MutSpan)> &kernel,
+                   const function<Vector3(size_t)> &expected) {
+        Vector3Array in = a, out(n);
+        Vector3Array &target = aliased ? in : out;
+        kernel(in.span(), target.span());
+        for (size_t i = 0; i < n; i++)
+            ok &= near(target, i, expected(i));
+    };
+    run([&](Vector3Span in, Vector3MutSpan out) { k.cross(in, b.span(), out, n); },
+        [&](size_t i) { return a.get(i).cross(b.get(i)); });
+    run([&](Vector3Span in, Vector3MutSpan out) { k.scale(in, s, out, n); },
+        [&](size_t i) { return a.get(i) * s; });
+    run([&](Vector3Span in, Vector3MutSpan out) { k.add(in, b.span(), out, n); },
+        [&](size_t i) { return a.get(i) + b.get(i); });
+    run([&](Vector3Span in, Vector3MutSpan out) { k.scaleAdd(in, b.span(), s, out, n); },
+        [&](size_t i) { return a.get(i) + b.get(i) * s; });
+
+    // norm only works in place.
+    Vector3Array normed = a;
+    k.norm(normed.span(), n);
+    for (size_t i = 0; i < n; i++) {
+        Vector3 v = a.get(i);
+        v.norm();
+        ok &= near(normed, i, v);
+    }
+    return ok;
+}
+
+/**
+ * @return <b>true</b> if every kernel of <b>k</b> gives bit for bit the results of <b>scalar</b>,
+ *         so that images do not depend on the CPU that rendered them
+ */
+static bool sameAsScalar(const Vector3Kernels &k, const Vector3Kernels &scalar, size_t n, mt19937_64 &rng) {
+    Vector3Array a = randomArray(n, rng), b = randomArray(n, rng);
+    const double s = 0.75;
+    bool ok = true;
+
+    vector<double> got(n), expected(n);
+    k.dot(a.span(), b.span(), got.data(), n);
+    scalar.dot(a.span(), b.span(), expected.data(), n);
+    ok &= got == expected;
+    k.len(a.span(), got.data(), n);
+    scalar.len(a.span(), expected.data(), n);
+    ok &= got == expected;
+    k.dist(a.span(), b.span(), got.data(), n);
+    scalar.dist(a.span(), b.span(), expected.data(), n);
+    ok &= got == expected;
+
+    auto compare = [&](const function<void(const Vector3Kernels &, Vector3MutSpan)> &kernel) {
+        Vector3Array mine(n), theirs(n);
+        kernel(k, mine.span());
+        kernel(scalar, theirs.span());
+        ok &= mine.x == theirs.x && mine.y == theirs.y && mine.z == theirs.z;
+    };
+    compare([&](const Vector3Kernels &t, Vector3MutSpan out) { t.cross(a.span(), b.span(), out, n); });
+    compare([&](const Vector3Kernels &t, Vector3MutSpan out) { t.scale(a.span(), s, out, n); });
+    compare([&](const Vector3Kernels &t, Vector3MutSpan out) { t.add(a.span(), b.span(), out, n); });
+    compare([&](const Vector3Kernels &t, Vector3MutSpan out) { t.scaleAdd(a.span(), b.span(), s, out, n); });
+    Vector3Array mine = a, theirs = a;
+    k.norm(mine.span(), n);
+    scalar.norm(theirs.span(), n);
+    ok &= mine.x == theirs.x && mine.y == theirs.y && mine.z == theirs.z;
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    mt19937_64 rng(26);
+    const Isa isas[] = {Isa::Scalar, Isa::SSE42, Isa::AVX2, Isa::AVX512};
+    const Vector3Kernels *best = nullptr;
+
+    for (Isa isa : isas) {
+        const Vector3Kernels *k = vector3Kernels(isa);
+        if (k == nullptr) {
+            cout << "      instruction set " << (int) isa << " is not supported here, skipped" << endl;
+            continue;
+        }
+        best = k;
+        check(k->isa == isa, string(k->name) + " table is the one asked for");
+        bool ok = true;
+        for (size_t n = 0; n <= 37; n++)
+            ok &= matchesScalar(*k, n, false, rng) && matchesScalar(*k, n, true, rng);
+        ok &= matchesScalar(*k, 1000, false, rng) && matchesScalar(*k, 1000, true, rng);
+        check(ok, string(k->name) + " kernels match Vector3, with and without aliased output");
+        if (isa != Isa::Scalar) {
+            check(sameAsScalar(*k, *vector3Kernels(Isa::Scalar), 1000, rng),
+                  string(k->name) + " kernels round exactly like the scalar ones");
+        }
+    }
+
+    if (argc == 3 && strcmp(argv[1], "--expect") == 0) {
+        const char *expected = strcmp(argv[2], "best") == 0 ? best->name : argv[2];
+        check(strcmp(vector3Kernels().name, expected) == 0,
+              string("BLA_VEC3_ISA picked ") + vector3Kernels().name + ", expected " + expected);
+    }
+    return checkResult();
+}